@@ -0,0 +1,118 @@
+/*
+ *	Program: hdf5 page cache advice v0.1
+ *
+ *	Usage: This code is free to use and modify, so long as this header remains intact, except for "Modifications" below.
+ *
+ *	Purpose: Page cache hints (posix_fadvise) for the bytes of one dataset
+ *			in its file, e.g. POSIX_FADV_WILLNEED so the kernel starts
+ *			reading a granule's geolocation before it is opened for real,
+ *			and POSIX_FADV_DONTNEED once it is no longer needed.
+ *
+ *		The byte ranges come from the layout: the whole storage of a
+ *		contiguous dataset (H5Dget_offset), or every allocated chunk of
+ *		a chunked one (H5Dget_chunk_info), adjacent chunks merged. Other
+ *		layouts (compact, external, virtual) are left alone.
+ *
+ *		The file is opened with the default (sec2) driver even when the
+ *		file image cache is enabled (hdf5_image.c): the layout query then
+ *		reads only metadata, not the whole file the advice is ahead of.
+ *
+ *	Functions
+ *		size_t		advise_variable_by_name		- bytes of the dataset the advice was given for
+ *
+ *	Constants
+ *		DEBUG_HDF5_ADVISE		- 1/0 - display debug information while executing (default 0)
+ *
+ *	Modifications:
+ *		2026-10-18				Original Version
+ *		2026-10-18				Layout read without the file image cache
+ */
+
+#define DEBUG_HDF5_ADVISE 0
+
+typedef struct {
+	haddr_t offset;
+	hsize_t size;
+} advise_range;
+
+int compare_advise_ranges(const void* a, const void* b) {
+	haddr_t x = ((const advise_range*) a)->offset;
+	haddr_t y = ((const advise_range*) b)->offset;
+	return x < y ? -1 : x > y;
+}
+
+size_t advise_variable_by_name(const char* path, const char* group, const char* name, int advice) {
+	if (DEBUG_HDF5_ADVISE) printf("advise_variable_by_name: %s %s %s %d\n", path, group, name, advice);
+
+	// Not open_file_by_name(), an image would read the whole file now
+	hid_t h5id     = H5Fopen(path, file_open_flags(), H5P_DEFAULT);
+	hid_t grp_h5id = h5id >= 0 ? H5Gopen(h5id, group, H5P_DEFAULT) : -1;
+	hid_t varid    = grp_h5id >= 0 ? H5Dopen(grp_h5id, name, H5P_DEFAULT) : -1;
+
+	if (varid < 0) {
+		if (grp_h5id >= 0) H5Gclose(grp_h5id);
+		if (h5id >= 0) H5Fclose(h5id);
+		return 0;
+	}
+
+	advise_range* ranges = NULL;
+	hsize_t range_count = 0;
+
+	hid_t dcpl = H5Dget_create_plist(varid);
+	H5D_layout_t layout = H5Pget_layout(dcpl);
+	int external = H5Pget_external_count(dcpl) != 0;
+	H5Pclose(dcpl);
+
+	if (layout == H5D_CONTIGUOUS && !external) {
+		haddr_t offset = H5Dget_offset(varid);
+		if (offset != HADDR_UNDEF) {
+			ranges = malloc(sizeof(advise_range));
+			ranges[0].offset = offset;
+			ranges[0].size = H5Dget_storage_size(varid);
+			range_count = 1;
+		}
+	} else if (layout == H5D_CHUNKED) {
+		hid_t dataset_space = H5Dget_space(varid);
+		hsize_t chunk_count = 0;
+		H5Dget_num_chunks(varid, dataset_space, &chunk_count);
+
+		ranges = malloc(sizeof(advise_range) * (chunk_count > 0 ? chunk_count : 1));
+
+		hsize_t k, offset[H5S_MAX_RANK];
+		unsigned filter_mask;
+		for (k = 0; k < chunk_count; k++) {
+			advise_range* r = &ranges[range_count];
+			if (H5Dget_chunk_info(varid, dataset_space, k, offset, &filter_mask, &r->offset, &r->size) >= 0 && r->offset != HADDR_UNDEF) range_count++;
+		}
+
+		H5Sclose(dataset_space);
+	}
+
+	H5Dclose(varid);
+	H5Gclose(grp_h5id);
+	H5Fclose(h5id);
+
+	// Chunks are usually written in order, merged they make few calls
+	if (range_count > 1) qsort(ranges, range_count, sizeof(advise_range), compare_advise_ranges);
+
+	size_t bytes = 0;
+	int fd = range_count > 0 ? open(path, O_RDONLY) : -1;
+
+	hsize_t k = 0;
+	while (fd >= 0 && k < range_count) {
+		haddr_t start = ranges[k].offset;
+		haddr_t end = start + ranges[k].size;
+		for (k++; k < range_count && ranges[k].offset <= end; k++) {
+			if (ranges[k].offset + ranges[k].size > end) end = ranges[k].offset + ranges[k].size;
+		}
+
+		if (posix_fadvise(fd, (off_t) start, (off_t) (end - start), advice) == 0) bytes += end - start;
+	}
+
+	if (fd >= 0) close(fd);
+	free(ranges);
+
+	if (DEBUG_HDF5_ADVISE) printf("advised %s: %lu ranges, %lu bytes\n", name, (unsigned long) range_count, (unsigned long) bytes);
+
+	return bytes;
+}
@@ -0,0 +1,265 @@
+/*
+ *	Program: hdf5 direct chunk reader v0.1
+ *
+ *	Usage: This code is free to use and modify, so long as this header remains intact, except for "Modifications" below.
+ *
+ *	Purpose: Load a whole 2-d chunked dataset with the chunks decompressed
+ *			in parallel, instead of H5Dread decompressing them one at a time.
+ *
+ *		The raw (still compressed) chunks are enumerated (H5Dget_chunk_info)
+ *		and fetched (H5Dread_chunk) on the calling thread, since the HDF5
+ *		library is not thread safe. Worker threads then undo the filter
+ *		pipeline and copy each chunk straight into the destination array.
+ *
+ *		Supported filters:	deflate (gzip), shuffle
+ *		Supported types:	the file type must match mem_type, apart from byte order
+ *
+ *		Anything else (szip, fletcher32, n-bit, scale-offset, type
+ *		conversion, 1-d or 3-d data) returns NULL so the caller can use
+ *		the normal H5Dread path.
+ *
+ *	Functions
+ *		void*		get_variable_data_by_name_direct	- returns a void* to 2-d data, cast as (type**), or NULL
+ *
+ *	Constants
+ *		DEBUG_HDF5_DIRECT		- 1/0 - display debug information while executing (default 0)
+ *
+ *	Modifications:
+ *		2026-10-18				Original Version
+ */
+
+#include <pthread.h>
+#include <zlib.h>
+
+#define DEBUG_HDF5_DIRECT 0
+
+#define MAX_DIRECT_FILTERS 8
+
+typedef struct {
+	hsize_t offset[2];
+	unsigned filter_mask;
+	size_t size;
+	unsigned char* raw;
+} direct_chunk;
+
+typedef struct {
+	direct_chunk* chunks;
+	hsize_t chunk_count;
+	hsize_t next;					// next chunk to decompress, guarded by lock
+	pthread_mutex_t lock;
+	int nfilters;
+	H5Z_filter_t filters[MAX_DIRECT_FILTERS];
+	size_t element_size;
+	int swap;						// file byte order differs from memory
+	hsize_t chunk_dims[2];
+	hsize_t dims[2];
+	char** data2d;					// destination, rows of bytes
+	int failed;
+} direct_load;
+
+int direct_filter_supported(H5Z_filter_t filter) {
+	return filter == H5Z_FILTER_DEFLATE || filter == H5Z_FILTER_SHUFFLE;
+}
+
+void direct_unshuffle(const unsigned char* in, unsigned char* out, size_t bytes, size_t element_size) {
+	size_t elements = bytes / element_size;
+	size_t e, b;
+	for (b = 0; b < element_size; b++) {
+		for (e = 0; e < elements; e++) {
+			out[e * element_size + b] = in[b * elements + e];
+		}
+	}
+	// a partial element at the end is not shuffled
+	memcpy(out + elements * element_size, in + elements * element_size, bytes - elements * element_size);
+}
+
+// Undo the filter pipeline of one chunk, then place it in the destination
+int direct_decode_chunk(direct_load* dl, direct_chunk* dc, unsigned char* work_a, unsigned char* work_b, size_t chunk_bytes) {
+
+	unsigned char* in = dc->raw;
+	size_t in_size = dc->size;
+	unsigned char* out = work_a;
+
+	int i;
+	for (i = dl->nfilters - 1; i >= 0; i--) {
+
+		// skipped filters are flagged per chunk
+		if (dc->filter_mask & (1u << i)) continue;
+
+		if (dl->filters[i] == H5Z_FILTER_DEFLATE) {
+			uLongf out_size = chunk_bytes;
+			if (uncompress(out, &out_size, in, in_size) != Z_OK) return 0;
+			in_size = out_size;
+		} else if (dl->filters[i] == H5Z_FILTER_SHUFFLE) {
+			direct_unshuffle(in, out, in_size, dl->element_size);
+		}
+
+		in = out;
+		out = (out == work_a) ? work_b : work_a;
+	}
+
+	if (in_size < chunk_bytes) return 0;
+
+	if (dl->swap) {
+		size_t e, b;
+		for (e = 0; e < chunk_bytes; e += dl->element_size) {
+			for (b = 0; b < dl->element_size / 2; b++) {
+				unsigned char t = in[e + b];
+				in[e + b] = in[e + dl->element_size - 1 - b];
+				in[e + dl->element_size - 1 - b] = t;
+			}
+		}
+	}
+
+	// Edge chunks are stored whole, copy only the part inside the dataset
+	hsize_t rows = dl->chunk_dims[0];
+	hsize_t cols = dl->chunk_dims[1];
+	if (dc->offset[0] + rows > dl->dims[0]) rows = dl->dims[0] - dc->offset[0];
+	if (dc->offset[1] + cols > dl->dims[1]) cols = dl->dims[1] - dc->offset[1];
+
+	hsize_t r;
+	for (r = 0; r < rows; r++) {
+		memcpy(dl->data2d[dc->offset[0] + r] + dc->offset[1] * dl->element_size,
+			in + r * dl->chunk_dims[1] * dl->element_size,
+			cols * dl->element_size);
+	}
+
+	return 1;
+}
+
+void* direct_worker(void* arg) {
+
+	direct_load* dl = (direct_load*) arg;
+
+	size_t chunk_bytes = dl->chunk_dims[0] * dl->chunk_dims[1] * dl->element_size;
+	unsigned char* work_a = malloc(chunk_bytes);
+	unsigned char* work_b = malloc(chunk_bytes);
+
+	while (1) {
+		pthread_mutex_lock(&dl->lock);
+		hsize_t k = dl->next++;
+		pthread_mutex_unlock(&dl->lock);
+
+		if (k >= dl->chunk_count) break;
+
+		if (!direct_decode_chunk(dl, &dl->chunks[k], work_a, work_b, chunk_bytes)) dl->failed = 1;
+	}
+
+	free(work_a);
+	free(work_b);
+
+	return NULL;
+}
+
+void* get_variable_data_by_name_direct(const char* path, const char* group, const char* name, hid_t mem_type, int threads) {
+	if (DEBUG_HDF5_DIRECT) printf("get_variable_data_by_name_direct: %s %s %s \n", path, group, name);
+
+	hid_t* ids     = (hid_t*) get_variable_ids_by_name(path, group, name);
+	hid_t h5id     = ids[0];
+	hid_t grp_h5id = ids[1];
+	hid_t varid    = ids[2];
+	free(ids);
+
+	direct_load dl;
+	memset(&dl, 0, sizeof(direct_load));
+
+	int usable = 1;
+
+	// Only 2-d chunked data of the requested type (in either byte order)
+	hid_t dataset_space = H5Dget_space(varid);
+	if (H5Sget_simple_extent_ndims(dataset_space) != 2) usable = 0;
+	if (usable) H5Sget_simple_extent_dims(dataset_space, dl.dims, NULL);
+
+	hid_t file_type = H5Dget_type(varid);
+	if (H5Tget_class(file_type) != H5Tget_class(mem_type) || H5Tget_size(file_type) != H5Tget_size(mem_type)) usable = 0;
+	if (H5Tget_class(file_type) == H5T_INTEGER && H5Tget_sign(file_type) != H5Tget_sign(mem_type)) usable = 0;
+	if (H5Tget_class(file_type) == H5T_FLOAT && !H5Tequal(file_type, mem_type)) {
+		// same float layout byte swapped, e.g. IEEE F32BE into native little endian
+		hid_t swapped = H5Tcopy(mem_type);
+		H5Tset_order(swapped, H5Tget_order(file_type));
+		if (!H5Tequal(file_type, swapped)) usable = 0;
+		H5Tclose(swapped);
+	}
+	dl.element_size = H5Tget_size(mem_type);
+	dl.swap = H5Tget_order(file_type) != H5Tget_order(mem_type) && dl.element_size > 1;
+	H5Tclose(file_type);
+
+	hid_t dcpl = H5Dget_create_plist(varid);
+	if (H5Pget_layout(dcpl) != H5D_CHUNKED) usable = 0;
+	if (usable) H5Pget_chunk(dcpl, 2, dl.chunk_dims);
+
+	dl.nfilters = usable ? H5Pget_nfilters(dcpl) : 0;
+	if (dl.nfilters > MAX_DIRECT_FILTERS) usable = 0;
+
+	int i;
+	for (i = 0; usable && i < dl.nfilters; i++) {
+		unsigned flags;
+		size_t cd_nelmts = 0;
+		unsigned filter_config;
+		dl.filters[i] = H5Pget_filter2(dcpl, i, &flags, &cd_nelmts, NULL, 0, NULL, &filter_config);
+		if (!direct_filter_supported(dl.filters[i])) usable = 0;
+	}
+	H5Pclose(dcpl);
+
+	if (usable) H5Dget_num_chunks(varid, dataset_space, &dl.chunk_count);
+
+	if (DEBUG_HDF5_DIRECT) printf("direct load %s: usable %d, %lu chunks, %d filters, swap %d\n",
+		name, usable, (unsigned long) dl.chunk_count, dl.nfilters, dl.swap);
+
+	void* data2d = NULL;
+
+	// Unallocated chunks would need the fill value, leave those to H5Dread
+	hsize_t chunks_across = (dl.dims[1] + dl.chunk_dims[1] - 1) / (dl.chunk_dims[1] > 0 ? dl.chunk_dims[1] : 1);
+	hsize_t chunks_down = (dl.dims[0] + dl.chunk_dims[0] - 1) / (dl.chunk_dims[0] > 0 ? dl.chunk_dims[0] : 1);
+	if (usable && dl.chunk_count != chunks_across * chunks_down) usable = 0;
+
+	if (usable) {
+		dl.chunks = calloc(dl.chunk_count, sizeof(direct_chunk));
+
+		// Raw chunk I/O stays on this thread
+		hsize_t k;
+		for (k = 0; k < dl.chunk_count && usable; k++) {
+			direct_chunk* dc = &dl.chunks[k];
+			haddr_t addr;
+			hsize_t size;
+			uint32_t filters;
+
+			if (H5Dget_chunk_info(varid, dataset_space, k, dc->offset, &dc->filter_mask, &addr, &size) < 0) usable = 0;
+
+			dc->size = size;
+			dc->raw = malloc(size > 0 ? size : 1);
+
+			if (usable && H5Dread_chunk(varid, H5P_DEFAULT, dc->offset, &filters, dc->raw) < 0) usable = 0;
+		}
+
+		if (usable) {
+			data2d = dimalloc(dl.element_size, 2, (size_t) dl.dims[0], (size_t) dl.dims[1]);
+			dl.data2d = (char**) data2d;
+
+			if (threads < 1) threads = 1;
+			pthread_t* workers = malloc(sizeof(pthread_t) * threads);
+			pthread_mutex_init(&dl.lock, NULL);
+
+			for (i = 0; i < threads; i++) pthread_create(&workers[i], NULL, direct_worker, &dl);
+			for (i = 0; i < threads; i++) pthread_join(workers[i], NULL);
+
+			pthread_mutex_destroy(&dl.lock);
+			free(workers);
+
+			if (dl.failed) {
+				free(data2d);
+				data2d = NULL;
+			}
+		}
+
+		for (k = 0; k < dl.chunk_count; k++) free(dl.chunks[k].raw);
+		free(dl.chunks);
+	}
+
+	H5Sclose(dataset_space);
+	H5Dclose(varid);
+	H5Gclose(grp_h5id);
+	H5Fclose(h5id);
+
+	return data2d;
+}
@@ -26,6 +26,9 @@
  *		void* 		get_variable_data_by_name			- returns a void* to 1-d data
  *		void* 		get_variable_data_by_name_dimalloc2	- returns a void* to 2-d data, cast as (type**),  reference as array[row][col]
  *		void* 		get_variable_data_by_name_dimalloc3	- returns a void* to 3-d data, cast as (type***), reference as array[lev][row][col]
+ *		void*		get_variable_hyperslab_by_name		- returns a void* to 1-d data of a (strided) hyperslab, read as mem_type
+ *		void*		get_variable_hyperslab_by_name_dimalloc2	- as above for 2-d data, cast as (type**), reference as array[row][col]
+ *		hid_t		open_variable_with_chunk_cache		- re-open a variable with a sized chunk cache (H5Pset_chunk_cache)
  *
  *	Internal functions
  *		void* 		get_variable_ids_by_name 			- returns a 3 element int array containing { ncid, grp_ncid, varid }
@@ -52,6 +55,11 @@
  *		2021-04-29		v 0.1	(SLJ)		Original VIIRS Version 
  *		2021-05			v 0.1	(SLJ)		Modified for HDF5 files
  *		2021-05-14				(SLJ)		Modified to use local HDF5 source codes
+ *		2026-10-18							Added hyperslab reads (start/stride/count, native memory type)
+ *		2026-10-18							Added chunk cache sizing on open
+ *		2026-10-18							Files opened through the file image cache (hdf5_image.c)
+ *		2026-10-18							get_variable_dims_by_name/get_variable_type_by_name close what they open
+ *		2026-10-18							SWMR readers refresh datasets on open
  */
  
 #include <stdlib.h>
@@ -60,6 +68,7 @@
 //#include "/usr/include/hdf5/serial/hdf5.h"
 #include "../../../hdf5-1.12.0/src/hdf5.h"
 #include "dimalloc3.c"
+#include "hdf5_image.c"
 
 #define DEBUG_HDF5_HELPER 0
 
@@ -716,8 +725,8 @@ void* convert_1d_to_3d(void *data_in, hid_t type, size_t levs, size_t rows, size
 void* get_variable_ids_by_name(const char* path, const char* group, const char* name) {
 	if (DEBUG_HDF5_HELPER) printf("get_variable_ids_by_name: %s %s %s \n", path, group, name);
 	
-	// Open the file by name
-	hid_t h5id = H5Fopen(path, H5F_ACC_RDONLY, H5P_DEFAULT);
+	// Open the file by name (from memory when file images are enabled, see hdf5_image.c)
+	hid_t h5id = open_file_by_name(path);
 	
 	// Determine group hierarchy based on full variable path name
 	hid_t grp_h5id = H5Gopen(h5id, group, H5P_DEFAULT);
@@ -750,6 +759,9 @@ void* get_variable_ids_by_name(const char* path, const char* group, const char*
 	
 	// Retrieve the varid by the variable name
 	hid_t varid = H5Dopen(grp_h5id, name, H5P_DEFAULT);
+
+	// A file being written may be open already with older metadata cached
+	if (file_swmr_read && varid >= 0) H5Drefresh(varid);
 	
 	hid_t* ret_ids = (hid_t*) malloc(sizeof(hid_t) * 3);
 	ret_ids[0] = h5id;
@@ -775,6 +787,7 @@ void* get_variable_dims(hid_t grp_h5id, hid_t varid) {
 	for (i = 0; i < MAX_DIMS; i++) dims[i] = 1;
 	
 	H5Sget_simple_extent_dims(dspace, dims, NULL);
+	H5Sclose(dspace);
 	
 	return (void*) dims;
 }
@@ -790,6 +803,9 @@ void* get_variable_dims_by_name(const char* path, const char* group, const char*
 	
 	size_t* dims = (size_t*) get_variable_dims(grp_h5id, varid);
 	
+	// Dataset and group first, an open one keeps the file (and its image, hdf5_image.c) in use
+	H5Dclose(varid);
+	H5Gclose(grp_h5id);
 	H5Fclose(h5id);
 	
 	return (void*) dims;
@@ -813,13 +829,17 @@ H5T_class_t get_variable_type_by_name(const char* path, const char* group, const
 	if (DEBUG_HDF5_HELPER) printf("get_variable_type_by_name: %s %s %s \n", path, group, name);
 	
 	hid_t* ids     = (hid_t*) get_variable_ids_by_name(path, group, name); // h5id remains open, need to close!
-	//hid_t h5id     = ids[0];
-	//hid_t grp_h5id = ids[1];
+	hid_t h5id     = ids[0];
+	hid_t grp_h5id = ids[1];
 	hid_t varid    = ids[2];
 	free(ids);
 	
 	H5T_class_t type = get_variable_type(varid);
 	
+	H5Dclose(varid);
+	H5Gclose(grp_h5id);
+	H5Fclose(h5id);
+	
 	return type;
 	
 }
@@ -1286,6 +1306,117 @@ void* get_variable_data_by_name_dimalloc3(const char* path, const char* group, c
 	return (void*) NULL;
 }
 
+/*
+ * Hyperslab reads
+ *
+ *	start, stride and count hold one entry per dimension of the variable
+ *	(stride may be NULL for a contiguous block). The data is converted by
+ *	HDF5 to mem_type, e.g. H5T_NATIVE_FLOAT, so byte order and width of
+ *	the file type do not matter to the caller. read_variable_hyperslab
+ *	returns a negative value on error, the _by_name readers NULL.
+ */
+herr_t read_variable_hyperslab(hid_t varid, hid_t mem_type, const hsize_t* start, const hsize_t* stride, const hsize_t* count, void* data) {
+
+	hid_t dataset_space = H5Dget_space(varid);
+	int ndims = H5Sget_simple_extent_ndims(dataset_space);
+
+	H5Sselect_hyperslab(dataset_space, H5S_SELECT_SET, start, stride, count, NULL);
+	hid_t memory_space = H5Screate_simple(ndims, count, NULL);
+
+	herr_t err = H5Dread(varid, mem_type, memory_space, dataset_space, H5P_DEFAULT, data);
+
+	H5Sclose(memory_space);
+	H5Sclose(dataset_space);
+
+	return err;
+}
+
+void* get_variable_hyperslab_by_name(const char* path, const char* group, const char* name, hid_t mem_type, const hsize_t* start, const hsize_t* stride, const hsize_t* count) {
+	if (DEBUG_HDF5_HELPER) printf("get_variable_hyperslab_by_name: %s %s %s \n", path, group, name);
+
+	hid_t* ids     = (hid_t*) get_variable_ids_by_name(path, group, name);
+	hid_t h5id     = ids[0];
+	hid_t grp_h5id = ids[1];
+	hid_t varid    = ids[2];
+	free(ids);
+
+	hid_t dataset_space = H5Dget_space(varid);
+	int ndims = H5Sget_simple_extent_ndims(dataset_space);
+	H5Sclose(dataset_space);
+
+	size_t total_data_count = 1;
+	int dim_i;
+	for (dim_i = 0; dim_i < ndims; dim_i++) total_data_count *= count[dim_i];
+
+	void* data = malloc(H5Tget_size(mem_type) * total_data_count);
+
+	if (read_variable_hyperslab(varid, mem_type, start, stride, count, data) < 0) {
+		free(data);
+		data = NULL;
+	}
+
+	H5Dclose(varid);
+	H5Gclose(grp_h5id);
+	H5Fclose(h5id);
+
+	return data;
+}
+
+void* get_variable_hyperslab_by_name_dimalloc2(const char* path, const char* group, const char* name, hid_t mem_type, const hsize_t* start, const hsize_t* stride, const hsize_t* count) {
+	if (DEBUG_HDF5_HELPER) printf("get_variable_hyperslab_by_name_dimalloc2: %s %s %s \n", path, group, name);
+
+	hid_t* ids     = (hid_t*) get_variable_ids_by_name(path, group, name);
+	hid_t h5id     = ids[0];
+	hid_t grp_h5id = ids[1];
+	hid_t varid    = ids[2];
+	free(ids);
+
+	// dimalloc keeps the data contiguous after the row pointers, read straight into it
+	void** data2d = dimalloc(H5Tget_size(mem_type), 2, (size_t) count[0], (size_t) count[1]);
+
+	if (data2d != NULL && read_variable_hyperslab(varid, mem_type, start, stride, count, data2d[0]) < 0) {
+		free(data2d);
+		data2d = NULL;
+	}
+
+	H5Dclose(varid);
+	H5Gclose(grp_h5id);
+	H5Fclose(h5id);
+
+	return (void*) data2d;
+}
+
+/*
+ * Chunk cache
+ *
+ *	HDF5 keeps 1 MB of decompressed chunks per open dataset by default,
+ *	too small to hold even one chunk of many products. The hash table
+ *	gets ~100 slots per chunk that fits, rounded up to a prime as the
+ *	HDF5 documentation recommends.
+ */
+hid_t open_variable_with_chunk_cache(hid_t grp_h5id, const char* name, size_t nbytes, size_t chunk_bytes) {
+
+	size_t nslots = 100 * (chunk_bytes > 0 ? nbytes / chunk_bytes + 1 : 1) + 1;
+	size_t d;
+	for (d = 3; d * d <= nslots; d += 2) {
+		if (nslots % d == 0) {
+			nslots += 2;
+			d = 1;
+		}
+	}
+
+	if (DEBUG_HDF5_HELPER) printf("chunk cache %s: %lu bytes, %lu slots\n", name, nbytes, nslots);
+
+	hid_t dapl = H5Pcreate(H5P_DATASET_ACCESS);
+	H5Pset_chunk_cache(dapl, nslots, nbytes, 1.0);
+
+	hid_t varid = H5Dopen(grp_h5id, name, dapl);
+
+	H5Pclose(dapl);
+
+	return varid;
+}
+
 /*
 int main() {
 
@@ -0,0 +1,183 @@
+/*
+ *	Program: hdf5 file image cache v0.1
+ *
+ *	Usage: This code is free to use and modify, so long as this header remains intact, except for "Modifications" below.
+ *
+ *	Purpose: Keep whole granules in memory and open them from there, with the
+ *			core driver over a file image (H5LTopen_file_image), instead of
+ *			reopening the file on disk for every table read. A granule is read
+ *			once, then every later open, dataset read and chunk fetch is a
+ *			memory access without syscalls or page cache lookups.
+ *
+ *		Images are shared by all opens of the same path (no copy per open)
+ *		and held until the total exceeds the budget, then the least recently
+ *		used image that no open file still refers to is dropped. A file larger
+ *		than the budget is opened from disk as usual. The cache is off until
+ *		set_file_image_budget() is given a non-zero budget.
+ *
+ *		set_file_swmr_read() opens every file as a SWMR reader instead,
+ *		for files still being written, and bypasses the images (a growing
+ *		file cannot be held as one).
+ *
+ *		An image counts as in use while a file id opened on it is valid. A
+ *		dataset or group left open after H5Fclose keeps reading the image,
+ *		so they are closed before their file (get_variable_data_by_name,
+ *		which keeps the whole file open, holds its image until the end).
+ *
+ *	Functions
+ *		void		set_file_image_budget		- bytes of file images to hold, 0 disables the cache
+ *		void		set_file_swmr_read			- open files as SWMR readers (H5F_ACC_SWMR_READ)
+ *		hid_t		open_file_by_name			- H5Fopen, read-only, from the image cache when enabled
+ *		size_t		file_image_loads			- images read from disk so far
+ *
+ *	Constants
+ *		DEBUG_HDF5_IMAGE		- 1/0 - display debug information while executing (default 0)
+ *		MAX_FILE_IMAGES			- images held at once
+ *		MAX_IMAGE_OPENS			- open files tracked per image
+ *
+ *	Modifications:
+ *		2026-10-18				Original Version
+ *		2026-10-18				SWMR reader opens
+ */
+
+#include <sys/stat.h>
+#include "../../../hdf5-1.12.0/hl/src/hdf5_hl.h"
+
+#define DEBUG_HDF5_IMAGE 0
+
+#define MAX_FILE_IMAGES 32
+#define MAX_IMAGE_OPENS 64
+
+typedef struct {
+	char* path;						// NULL when the slot is free
+	void* image;
+	size_t size;
+	unsigned long last_used;
+	hid_t opens[MAX_IMAGE_OPENS];	// file ids opened on the image, may have been closed since
+	int open_count;
+} file_image;
+
+file_image file_images[MAX_FILE_IMAGES];
+
+size_t file_image_budget = 0;
+size_t file_image_bytes = 0;
+size_t file_image_reads = 0;
+unsigned long file_image_clock = 0;
+int file_swmr_read = 0;
+
+void set_file_image_budget(size_t bytes) {
+	file_image_budget = bytes;
+}
+
+void set_file_swmr_read(int swmr) {
+	file_swmr_read = swmr;
+}
+
+unsigned file_open_flags() {
+	return file_swmr_read ? H5F_ACC_RDONLY | H5F_ACC_SWMR_READ : H5F_ACC_RDONLY;
+}
+
+size_t file_image_loads() {
+	return file_image_reads;
+}
+
+// Drop file ids the caller has closed, returns the ids still open
+int file_image_prune(file_image* fi) {
+	int i, kept = 0;
+	for (i = 0; i < fi->open_count; i++) {
+		if (H5Iis_valid(fi->opens[i]) > 0) fi->opens[kept++] = fi->opens[i];
+	}
+	fi->open_count = kept;
+	return kept;
+}
+
+// Evict least recently used images until 'bytes' more would fit in the budget
+int file_image_make_room(size_t bytes) {
+
+	while (file_image_bytes + bytes > file_image_budget) {
+
+		file_image* victim = NULL;
+		int i;
+		for (i = 0; i < MAX_FILE_IMAGES; i++) {
+			file_image* fi = &file_images[i];
+			if (fi->path == NULL || file_image_prune(fi) > 0) continue;
+			if (victim == NULL || fi->last_used < victim->last_used) victim = fi;
+		}
+
+		if (victim == NULL) return 0;
+
+		if (DEBUG_HDF5_IMAGE) printf("file image evict: %s (%lu bytes)\n", victim->path, (unsigned long) victim->size);
+
+		file_image_bytes -= victim->size;
+		free(victim->path);
+		free(victim->image);
+		victim->path = NULL;
+	}
+
+	return 1;
+}
+
+file_image* file_image_load(const char* path) {
+
+	struct stat st;
+	if (stat(path, &st) != 0 || st.st_size <= 0 || (size_t) st.st_size > file_image_budget) return NULL;
+
+	size_t size = st.st_size;
+	if (!file_image_make_room(size)) return NULL;
+
+	int slot;
+	for (slot = 0; slot < MAX_FILE_IMAGES && file_images[slot].path != NULL; slot++);
+	if (slot == MAX_FILE_IMAGES) return NULL;
+
+	FILE* fp = fopen(path, "rb");
+	if (fp == NULL) return NULL;
+
+	void* image = malloc(size);
+	size_t got = fread(image, 1, size, fp);
+	fclose(fp);
+
+	if (got != size) {
+		free(image);
+		return NULL;
+	}
+
+	if (DEBUG_HDF5_IMAGE) printf("file image load: %s (%lu bytes)\n", path, (unsigned long) size);
+
+	file_image* fi = &file_images[slot];
+	fi->path = strdup(path);
+	fi->image = image;
+	fi->size = size;
+	fi->open_count = 0;
+
+	file_image_bytes += size;
+	file_image_reads++;
+
+	return fi;
+}
+
+hid_t open_file_by_name(const char* path) {
+
+	if (file_image_budget == 0 || file_swmr_read) return H5Fopen(path, file_open_flags(), H5P_DEFAULT);
+
+	file_image* fi = NULL;
+	int i;
+	for (i = 0; i < MAX_FILE_IMAGES; i++) {
+		if (file_images[i].path != NULL && strcmp(file_images[i].path, path) == 0) fi = &file_images[i];
+	}
+
+	if (fi == NULL) fi = file_image_load(path);
+
+	if (fi == NULL || (fi->open_count == MAX_IMAGE_OPENS && file_image_prune(fi) == MAX_IMAGE_OPENS)) {
+		return H5Fopen(path, file_open_flags(), H5P_DEFAULT);
+	}
+
+	fi->last_used = ++file_image_clock;
+
+	// The image stays owned by the cache, shared read-only by every open
+	hid_t h5id = H5LTopen_file_image(fi->image, fi->size, H5LT_FILE_IMAGE_DONT_COPY | H5LT_FILE_IMAGE_DONT_RELEASE);
+	if (h5id < 0) return H5Fopen(path, file_open_flags(), H5P_DEFAULT);
+
+	fi->opens[fi->open_count++] = h5id;
+
+	return h5id;
+}
@@ -0,0 +1,173 @@
+/*
+ *	Program: hdf5 mapped dataset reader v0.1
+ *
+ *	Usage: This code is free to use and modify, so long as this header remains intact, except for "Modifications" below.
+ *
+ *	Purpose: Zero-copy access to a contiguous, unfiltered 2-d dataset stored
+ *			in native byte order. The dataset's bytes are mapped read-only
+ *			straight from the file (H5Dget_offset, mmap) and only the row
+ *			pointers are allocated, so the result is used as array[row][col]
+ *			like a dimalloc'd array. Mapped pages come from the page cache,
+ *			shared by every process on the node reading the same granule.
+ *
+ *		Anything else (chunked or filtered layout, byte order or type
+ *		conversion, unallocated storage, external files, misaligned data)
+ *		returns NULL so the caller can use the normal H5Dread path.
+ *
+ *		The table of mappings is shared by every thread (e.g. the -A I/O
+ *		thread of pipeline.c reading ahead of the searches, or the -D watch
+ *		workers reading granules in parallel), it is only touched under
+ *		mmap_regions_lock.
+ *
+ *	Functions
+ *		void*		get_variable_data_by_name_mmap		- returns a void* to 2-d data, cast as (type**), or NULL
+ *		void		free_variable_data					- free a 2-d array from either the mapped or dimalloc path
+ *		int			find_mmap_region					- slot of a mapping in the table, -1 if none
+ *
+ *	Constants
+ *		DEBUG_HDF5_MMAP			- 1/0 - display debug information while executing (default 0)
+ *		MAX_MMAP_REGIONS		- mappings held at once
+ *
+ *	Modifications:
+ *		2026-10-18				Original Version
+ *		2026-10-18				mmap_regions_lock around the table of mappings
+ */
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define DEBUG_HDF5_MMAP 0
+
+#define MAX_MMAP_REGIONS 16
+
+typedef struct {
+	void* rows;						// row pointers handed to the caller
+	void* base;						// page aligned start of the mapping
+	size_t length;
+} mmap_region;
+
+mmap_region mmap_regions[MAX_MMAP_REGIONS];
+pthread_mutex_t mmap_regions_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Slot of data in the table, -1 when not there (data NULL for a free slot), mmap_regions_lock held
+int find_mmap_region(void* data) {
+	int slot;
+	for (slot = 0; slot < MAX_MMAP_REGIONS; slot++) {
+		if (mmap_regions[slot].rows == data) return slot;
+	}
+	return -1;
+}
+
+void* get_variable_data_by_name_mmap(const char* path, const char* group, const char* name, hid_t mem_type) {
+	if (DEBUG_HDF5_MMAP) printf("get_variable_data_by_name_mmap: %s %s %s \n", path, group, name);
+
+	pthread_mutex_lock(&mmap_regions_lock);
+	int full = find_mmap_region(NULL) < 0;
+	pthread_mutex_unlock(&mmap_regions_lock);
+	if (full) return NULL;
+
+	hid_t* ids     = (hid_t*) get_variable_ids_by_name(path, group, name);
+	hid_t h5id     = ids[0];
+	hid_t grp_h5id = ids[1];
+	hid_t varid    = ids[2];
+	free(ids);
+
+	int usable = 1;
+	hsize_t dims[2] = { 0, 0 };
+
+	hid_t dataset_space = H5Dget_space(varid);
+	if (H5Sget_simple_extent_ndims(dataset_space) != 2) usable = 0;
+	if (usable) H5Sget_simple_extent_dims(dataset_space, dims, NULL);
+	H5Sclose(dataset_space);
+
+	// Bytes in the file must already be the memory layout
+	hid_t file_type = H5Dget_type(varid);
+	if (!H5Tequal(file_type, mem_type)) usable = 0;
+	H5Tclose(file_type);
+
+	hid_t dcpl = H5Dget_create_plist(varid);
+	if (H5Pget_layout(dcpl) != H5D_CONTIGUOUS) usable = 0;
+	if (H5Pget_nfilters(dcpl) != 0) usable = 0;
+	if (H5Pget_external_count(dcpl) != 0) usable = 0;
+	H5Pclose(dcpl);
+
+	size_t element_size = H5Tget_size(mem_type);
+	size_t bytes = dims[0] * dims[1] * element_size;
+
+	haddr_t offset = usable ? H5Dget_offset(varid) : HADDR_UNDEF;
+	if (offset == HADDR_UNDEF || offset % element_size != 0) usable = 0;
+
+	H5Dclose(varid);
+	H5Gclose(grp_h5id);
+	H5Fclose(h5id);
+
+	if (DEBUG_HDF5_MMAP) printf("mmap %s: usable %d, offset %lu, %lu bytes\n",
+		name, usable, (unsigned long) offset, (unsigned long) bytes);
+
+	if (!usable || bytes == 0) return NULL;
+
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) return NULL;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || (off_t) (offset + bytes) > st.st_size) {
+		close(fd);
+		return NULL;
+	}
+
+	// mmap offsets must be page aligned
+	size_t page = sysconf(_SC_PAGESIZE);
+	off_t map_offset = offset - offset % page;
+	size_t map_length = bytes + (offset - map_offset);
+
+	void* base = mmap(NULL, map_length, PROT_READ, MAP_SHARED, fd, map_offset);
+	close(fd);
+
+	if (base == MAP_FAILED) return NULL;
+
+	madvise(base, map_length, MADV_WILLNEED);
+
+	char* data = (char*) base + (offset - map_offset);
+	char** data2d = malloc(sizeof(char*) * dims[0]);
+
+	hsize_t r;
+	for (r = 0; r < dims[0]; r++) data2d[r] = data + r * dims[1] * element_size;
+
+	// Another thread may have taken the last slot meanwhile
+	pthread_mutex_lock(&mmap_regions_lock);
+	int slot = find_mmap_region(NULL);
+	if (slot >= 0) {
+		mmap_regions[slot].rows = data2d;
+		mmap_regions[slot].base = base;
+		mmap_regions[slot].length = map_length;
+	}
+	pthread_mutex_unlock(&mmap_regions_lock);
+
+	if (slot < 0) {
+		munmap(base, map_length);
+		free(data2d);
+		return NULL;
+	}
+
+	return data2d;
+}
+
+void free_variable_data(void* data) {
+
+	if (data == NULL) return;
+
+	pthread_mutex_lock(&mmap_regions_lock);
+	mmap_region region = { NULL, NULL, 0 };
+	int slot = find_mmap_region(data);
+	if (slot >= 0) {
+		region = mmap_regions[slot];
+		mmap_regions[slot].rows = NULL;
+	}
+	pthread_mutex_unlock(&mmap_regions_lock);
+
+	if (region.base != NULL) munmap(region.base, region.length);
+
+	free(data);
+}
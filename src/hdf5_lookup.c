@@ -37,6 +37,7 @@
  *		distance_in_km			(calculated, great circle distance in kilometers)
  *		observation_latitude	(found in nc file)
  *		observation_longitude	(found in nc file)
+ *		observation_time		(-t only, scan time of the pixel)
  *		variable_1_value		(found in nc file)
  *		...
  *		variable_n_value
@@ -45,10 +46,116 @@
  *		2021 04 29 - Initial Version
  *		2021 04 29 - Modified to open hdf5 files instead of misr
  *		2021 04 30 - Added 'autoscale' to nearest for undersized datasets
+ *		2026 10 18 - Added -T tie-point geolocation search
+ *		2026 10 18 - Added -p coarse-to-fine strided geolocation search
+ *		2026 10 18 - Added -b batch targets, searched in Hilbert order, variables read in chunk order
+ *		2026 10 18 - Added -s read statistics (chunks read versus elements returned)
+ *		2026 10 18 - Added -j parallel chunk decompression of lat/lon
+ *		2026 10 18 - Contiguous native lat/lon are memory mapped
+ *		2026 10 18 - Added -m in-memory file images
+ *		2026 10 18 - Float, double and scaled integer lat/lon (hdf5_lookup.src/geotable.c)
+ *		2026 10 18 - Validity bitmap replaces the fill test in the search loop
+ *		2026 10 18 - Added -q quality flag filtered search
+ *		2026 10 18 - Added -r inverse lookup raster, -c sidecar cache
+ *		2026 10 18 - Added -g/-o swath to grid resampling
+ *		2026 10 18 - Added -a region aggregation
+ *		2026 10 18 - Added -w/-W N x N neighborhood windows
+ *		2026 10 18 - Added -C swath to swath collocation
+ *		2026 10 18 - Added -t space/time search with per scan times
+ *		2026 10 18 - Added -G multi-granule virtual swath
+ *		2026 10 18 - Added -V orbit file of virtual datasets
+ *		2026 10 18 - Added -F follow mode for files still being written (SWMR)
+ *		2026 10 18 - Added -D directory watch with background indexing, -G -c sidecars
+ *		2026 10 18 - Added -z packed in-memory geolocation
+ *		2026 10 18 - Added -M memory mapped result cache
+ *		2026 10 18 - Added -A asynchronous reads for -G
+ *		2026 10 18 - Added -R page cache read-ahead for -G
+ *		2026 10 18 - Added -e approximate search within a tolerance
+ *		2026 10 18 - Orbit file lookups searched granule by granule
+ *		2026 10 18 - -t with -G, granules pruned by their time range
  
  Command:
  
-  $ ./hdf5_lookup File VarTable1 {VarTable2} LatTable LonTable target_lat target_lon
+  $ ./hdf5_lookup {options} File VarTable1 {VarTable2} LatTable LonTable target_lat target_lon
+ 
+ Options:
+  -T row_step,col_step{,rows_per_scan}
+						LatTable/LonTable are tie-point grids at the given spacing,
+						VarTable1 gives the full resolution (see hdf5_lookup.src/tiepoint.c)
+  -p N					read LatTable/LonTable every Nth row/col, then refine around
+						the best samples (see hdf5_lookup.src/pyramid.c)
+  -b targets			read "lat lon" lines from the targets file ("-" for stdin)
+						instead of target_lat target_lon (see hdf5_lookup.src/batch.c)
+  -s					print read statistics to stderr (see hdf5_lookup.src/stats.c)
+  -j threads			decompress LatTable/LonTable chunks on threads, for gzip/shuffle
+						filters (see hdf5_helper.src/hdf5_direct.c)
+  -m MB					hold files in memory, up to MB, and open them from there
+						(see hdf5_helper.src/hdf5_image.c)
+  -q FlagTable:mask:value
+						only pixels with (flag & mask) == value are searched, the flag
+						table has the search resolution (see hdf5_lookup.src/validity.c)
+  -r deg				index LatTable/LonTable in a deg x deg inverse raster, each query
+						refines over the pixels of a few cells (see hdf5_lookup.src/raster.c)
+  -c					keep the -r raster in File.raster and reuse it while File is unchanged
+  -g south,north,west,east,deg
+						resample the variables onto a deg x deg lat/lon grid instead of
+						target_lat target_lon, nearest pixel per cell through the -r
+						raster (default 0.05) (see hdf5_lookup.src/grid.c)
+  -o Out.h5				output file for -g, -C and -V
+  -a south,north,west,east | Polygon.txt
+						count, mean, stddev, min and max of each variable over the
+						pixels inside a box or a polygon ("lat lon" vertex lines),
+						instead of target_lat target_lon (see hdf5_lookup.src/region.c)
+  -w N					N x N window of each variable around the located pixel, N * N
+						values row by row, nan outside the granule (see hdf5_lookup.src/window.c)
+  -W N					valid_count mean stddev of the N x N window instead of its values
+  -C SourceFile:SourceLatTable:SourceLonTable
+						match every pixel of the source swath with the nearest pixel of
+						File, written to -o Out.h5 with the variables gathered to the
+						source pixels, instead of target_lat target_lon
+						(see hdf5_lookup.src/collocate.c)
+  -t TimeTable:window{:km_per_unit}
+						targets have a time (target_lat target_lon target_time, or a
+						third -b column), only scans of TimeTable within window of it
+						are searched, ranked by space and time with km_per_unit; with -G
+						granules out of the window are not searched for the target
+						(see hdf5_lookup.src/scantime.c)
+  -G					File is a list of granules in orbit order ("-" for stdin),
+						searched as one swath, geolocation loaded per granule
+						(see hdf5_lookup.src/virtual.c)
+  -V					write -o Orbit.h5, every table of the File granule list
+						(VarTables, LatTable, LonTable) as one virtual dataset
+						along the track, instead of target_lat target_lon. Later
+						lookups take Orbit.h5 as File and search it granule by granule
+						as -G does, reading only the granules near the targets
+						(see hdf5_lookup.src/orbit.c)
+  -F interval{:idle}	File is still being written (SWMR): poll it every interval
+						seconds, search only the appended rows and print each -b
+						target once rows past its match arrive; the file is done
+						after idle seconds without rows (see hdf5_lookup.src/follow.c)
+  -D Dir				watch Dir (inotify) and index every granule landing there on
+						-j workers: -r raster (default 0.05) written to its sidecar,
+						then the granule and its bounds published to the File catalog.
+						Takes File LatTable LonTable only. Query the catalog with
+						-G -r deg -c (see hdf5_lookup.src/watch.c)
+  -z					hold LatTable/LonTable packed, quantized to within 0.22 m
+						(about a third of float size), decoded per block by the
+						searches (see hdf5_lookup.src/packed.c)
+  -M Cache{:MB}			keep each target's output line in the Cache file (MB, default
+						64, least recently used lines evicted), keyed by File's path,
+						size and time, the tables, options and target; cached targets
+						are not searched, and File is not opened when all are
+						(see hdf5_lookup.src/memo.c)
+  -A depth				with -G, read on an I/O thread while searching: the geolocation
+						of up to depth granules ahead, the variables of the granules
+						searched behind (see hdf5_lookup.src/pipeline.c)
+  -R N					with -G, have the kernel read the LatTable/LonTable chunks of
+						the next N granules into the page cache, and drop them once
+						searched (posix_fadvise, see hdf5_helper.src/hdf5_advise.c)
+  -e km{:verify}		approximate raster search (-r, default 0.05): the pixel found is
+						at most km further than the nearest, the bound achieved is in
+						-s; :verify checks every target against the brute force search
+						and fails on any result beyond km (see hdf5_lookup.src/approx.c)
  
  Example:
  
@@ -88,73 +195,51 @@ double gc_distance(double lat_0, double lon_0, double lat_1, double lon_1) {
 	return c * 6367.; // km
 }
  
-void* get_indices_from_lat_long(float** data_lat, float** data_lon, double target_lat, double target_lon, int rows, int cols) {
-	
-	double closest = 99999;
-	
-	// Start in the center of the data
-	int closest_col = -9999;
-	int closest_row = -9999;
-	
-	int found = 0;
-	
-	do {
-			
-		int tmp_col = closest_col;
-		int tmp_row = closest_row;
-		
-		int col, row;
-		
-		for(row = 0; row < rows; row++) {
-			for(col = 0; col < cols; col++) {
-				
-				float lat = data_lat[row][col];
-				float lon = data_lon[row][col];
-				
-				if ((lat > -9999) && (lon > -9999)) {
-				
-					double distance = gc_distance(lat, lon, target_lat, target_lon);
-					
-					// if any of those are closer to target then move there and repeat
-					if (closest > distance) {
-					
-						if (DEBUG_HDF5_LOOKUP) printf("%10d ", row * cols + col);
-						if (DEBUG_HDF5_LOOKUP) printf("%11.4f %11.4f ", lat, lon);
-						if (DEBUG_HDF5_LOOKUP) printf("%4d %4d ", row, col);
-						if (DEBUG_HDF5_LOOKUP) printf("%8.3e ", distance);
-						if (DEBUG_HDF5_LOOKUP) printf("\n");
-
-						tmp_col = col;
-						tmp_row = row;
-						closest = distance;
-					}
-				}
-			}
-		}
+// Split "/group/name" into malloc'd "/group/" and "name"
+void split_table_path(const char* table, char** group, char** name) {
 
-		// if no neighbors are closer, then closest one has been found
-		if ((closest_col == tmp_col) && (closest_row == tmp_row)) {
-			found = 1;
-		} else {
-			closest_col = tmp_col;
-			closest_row = tmp_row;
-		}
+	char* group_end = strrchr(table, (int) '/');
+	int group_len = group_end - table + 1;
+	*group = malloc(sizeof(char) * (group_len + 1));
+	strncpy(*group, table, group_len);
+	(*group)[group_len] = 0;
 
-	// Repeat until the walk ends
-	} while (found == 0);
-	
-	int* ret_vals = malloc(sizeof(int) * 3);
-	
-	ret_vals[0] = closest_row;
-	ret_vals[1] = closest_col;
-	ret_vals[2] = closest;
-	
-	return (void*) ret_vals;
+	long name_len = strlen(table) - group_len;
+	*name = malloc(sizeof(char) * (name_len + 1));
+	strncpy(*name, table + group_len, name_len);
+	(*name)[name_len] = 0;
 }
 
 void usage(int argc, char** argv) {
 
-	printf("\n%s File/Path Group1/VarTable1 {Group2/VarTable2 {...}} LatGroup/LatTable LonGroup/LonTable target_lat target_lon\n\n", argv[0]);
+	printf("\n%s {options} File/Path Group1/VarTable1 {Group2/VarTable2 {...}} LatGroup/LatTable LonGroup/LonTable target_lat target_lon\n\n", argv[0]);
+
+	printf("OPTIONS:\n");
+	printf("  -T row_step,col_step{,rows_per_scan}   lat/lon tables are tie-point grids\n");
+	printf("  -p N                                   coarse-to-fine search reading every Nth row/col first\n");
+	printf("  -b targets                             \"lat lon\" per line (\"-\" = stdin) replaces target_lat target_lon\n");
+	printf("  -s                                     print read statistics to stderr\n");
+	printf("  -j threads                             decompress lat/lon chunks on threads\n");
+	printf("  -m MB                                  hold files in memory (up to MB) and open them from there\n");
+	printf("  -q FlagTable:mask:value                only search pixels with (flag & mask) == value\n");
+	printf("  -r deg                                 search through a deg x deg inverse lookup raster\n");
+	printf("  -c                                     cache the -r raster in File.raster\n");
+	printf("  -g south,north,west,east,deg           resample onto a lat/lon grid, replaces target_lat target_lon\n");
+	printf("  -o Out.h5                              output file for -g, -C and -V\n");
+	printf("  -a south,north,west,east | Polygon.txt statistics of each variable inside a region\n");
+	printf("  -w N                                   N x N window of values around the located pixel\n");
+	printf("  -W N                                   valid count, mean and stddev of the N x N window\n");
+	printf("  -C SourceFile:SourceLat:SourceLon      collocate every source pixel with File, written to -o\n");
+	printf("  -t TimeTable:window{:km_per_unit}      search the scans within window of target_time, nearest in space and time\n");
+	printf("  -G                                     File lists granules in orbit order, searched as one swath\n");
+	printf("  -V                                     stitch the tables of the File granule list into -o Orbit.h5 (virtual datasets)\n");
+	printf("  -F interval{:idle}                     follow File while it is written (SWMR), answer -b targets as their rows arrive\n");
+	printf("  -D Dir                                 index granules landing in Dir on -j workers, publish them to the File catalog\n");
+	printf("  -z                                     hold lat/lon packed (quantized, within 0.22 m), decoded per block\n");
+	printf("  -M Cache{:MB}                          cache output lines per target in a memory mapped file (LRU, MB cap)\n");
+	printf("  -A depth                               with -G, read up to depth granules ahead on an I/O thread while searching\n");
+	printf("  -R N                                   with -G, page cache read-ahead of the next N granules' lat/lon, dropped once searched\n");
+	printf("  -e km{:verify}                         approximate raster search, at most km further than the nearest pixel\n\n");
 	
 	printf("EXAMPLE:\n");
 	printf("./viirs_lookup ~/VIIRS_data/night/GDNBO/GDNBO_npp_d20180101_t0859256_e0905060_b32021_c20180101150505919989_noac_ops.h5 /All_Data/VIIRS-DNB-GEO_All/SatelliteZenithAngle /All_Data/VIIRS-DNB-GEO_All/SatelliteZenithAngle /All_Data/VIIRS-DNB-GEO_All/Latitude /All_Data/VIIRS-DNB-GEO_All/Longitude 32.13 -111.09\n");
@@ -165,13 +250,167 @@ void usage(int argc, char** argv) {
 	// /All_Data/VIIRS-DNB-GEO_All/MidTime
 }
 
+// target_lat target_lon distance obs_lat obs_lon {obs_time}, the start of an output line
+void print_target(FILE* fp, lookup_target* t, int timed) {
+
+	fprintf(fp, "%10.6f %10.6f %6.4f %10.6f %10.6f",
+		t->lat,
+		t->lon,
+		t->distance,
+		t->obs_lat,
+		t->obs_lon);
+
+	if (timed) fprintf(fp, " %.17g", t->obs_time);
+}
+
+void print_value(FILE* fp, lookup_value* value, H5T_class_t data_type) {
+	if (data_type == H5T_INTEGER && value->i == LOOKUP_UNREAD_INT) {
+		fprintf(fp, " nan");
+	} else if (data_type == H5T_INTEGER) {
+		fprintf(fp, " %lld", value->i);
+	} else if (data_type == H5T_FLOAT) {
+		fprintf(fp, " %f", value->f);
+	}
+}
+
 int main (int argc, char** argv) {
 	// Parse input line and verify file exists
 	
 	// ./hdf5_lookup File VarTable1 {VarTable2} LatTable LonTable target_lat target_lon
+	// ./hdf5_lookup -b targets File VarTable1 {VarTable2} LatTable LonTable
+	// ./hdf5_lookup -g south,north,west,east,deg -o Out.h5 File VarTable1 {VarTable2} LatTable LonTable
+	// ./hdf5_lookup -a south,north,west,east File VarTable1 {VarTable2} LatTable LonTable
+	// ./hdf5_lookup -C SourceFile:SourceLat:SourceLon -o Out.h5 File VarTable1 {VarTable2} LatTable LonTable
+	// ./hdf5_lookup -V -o Orbit.h5 Granules.txt VarTable1 {VarTable2} LatTable LonTable
+	// ./hdf5_lookup -D Dir {-r deg} {-j workers} Catalog LatTable LonTable
+	// ./hdf5_lookup -t TimeTable:window File VarTable1 {VarTable2} LatTable LonTable target_lat target_lon target_time
 	// TODO ./hdf5_lookup VarFile1:VarTable1 {VarFile2:VarTable2} LatFile:LatTable LonFile:LonTable target_lat target_lon
 	
-	if (argc < 7) {
+	char* tiepoint_spec = NULL;
+	int pyramid_stride = 0;
+	char* batch_file = NULL;
+	int print_stats = 0;
+	int threads = 0;
+	size_t image_mb = 0;
+	char* flag_spec = NULL;
+	double raster_cell = 0;
+	int raster_sidecar = 0;
+	char* grid_arg = NULL;
+	char* grid_file = NULL;
+	char* region_arg = NULL;
+	int window_size = 0;
+	int window_summary = 0;
+	char* collocate_arg = NULL;
+	char* time_spec = NULL;
+	int granule_list_file = 0;
+	int orbit_file = 0;
+	char* follow_spec = NULL;
+	char* watch_dir = NULL;
+	char* memo_spec = NULL;
+	int io_depth = 0;
+	int readahead = 0;
+	char* approx_spec = NULL;
+
+	// '+' stops at the first positional so negative coordinates are not options
+	int opt;
+	while ((opt = getopt(argc, argv, "+T:p:b:sj:m:q:r:cg:o:a:w:W:C:t:GVF:D:zM:A:R:e:")) != -1) {
+		switch (opt) {
+			case 'T':
+				tiepoint_spec = optarg;
+				break;
+			case 'p':
+				pyramid_stride = atoi(optarg);
+				break;
+			case 'b':
+				batch_file = optarg;
+				break;
+			case 's':
+				print_stats = 1;
+				break;
+			case 'j':
+				threads = atoi(optarg);
+				break;
+			case 'm':
+				image_mb = atoi(optarg);
+				break;
+			case 'q':
+				flag_spec = optarg;
+				break;
+			case 'r':
+				raster_cell = atof(optarg);
+				break;
+			case 'c':
+				raster_sidecar = 1;
+				break;
+			case 'g':
+				grid_arg = optarg;
+				break;
+			case 'o':
+				grid_file = optarg;
+				break;
+			case 'a':
+				region_arg = optarg;
+				break;
+			case 'w':
+			case 'W':
+				window_size = atoi(optarg);
+				window_summary = opt == 'W';
+				break;
+			case 'C':
+				collocate_arg = optarg;
+				break;
+			case 't':
+				time_spec = optarg;
+				break;
+			case 'G':
+				granule_list_file = 1;
+				break;
+			case 'V':
+				orbit_file = 1;
+				break;
+			case 'F':
+				follow_spec = optarg;
+				break;
+			case 'D':
+				watch_dir = optarg;
+				break;
+			case 'z':
+				set_geolocation_packing(1);
+				break;
+			case 'M':
+				memo_spec = optarg;
+				break;
+			case 'A':
+				io_depth = atoi(optarg);
+				break;
+			case 'R':
+				readahead = atoi(optarg);
+				break;
+			case 'e':
+				approx_spec = optarg;
+				break;
+			default:
+				usage(argc, argv);
+				return 1;
+		}
+	}
+
+	// Drop the options, keeping the program name in argv[0]
+	argv[optind - 1] = argv[0];
+	argc -= optind - 1;
+	argv += optind - 1;
+
+	set_file_image_budget(image_mb * 1024 * 1024);
+
+	// Batch targets come from a file rather than the last two arguments
+	if (batch_file != NULL || grid_arg != NULL || region_arg != NULL || collocate_arg != NULL || orbit_file || watch_dir != NULL) argc += 2;
+
+	// A single timed target ends with target_time
+	char* target_time = NULL;
+	if (time_spec != NULL && batch_file == NULL && argc > 1) target_time = argv[--argc];
+
+	// A watch has no variables: Catalog LatTable LonTable
+	if (argc < (watch_dir != NULL ? 6 : 7)) {
 		printf("Too few arguments\n");
 		usage(argc, argv);
 		return 1;
@@ -179,31 +418,379 @@ int main (int argc, char** argv) {
 		//printf("have %d args\n", argc);
 	// }
 	
+	if (tiepoint_spec != NULL && pyramid_stride > 0) {
+		printf("-T and -p can not be combined\n");
+		return 1;
+	}
+
+	if (window_size != 0 && (window_size < 1 || window_size > MAX_WINDOW || window_size % 2 == 0 || grid_arg != NULL || region_arg != NULL)) {
+		printf("-w/-W need an odd window size from 1 to %d, without -g or -a\n", MAX_WINDOW);
+		return 1;
+	}
+
+	grid_spec grid;
+	if (grid_arg != NULL) {
+		if (!parse_grid_spec(grid_arg, &grid) || grid_file == NULL || batch_file != NULL) {
+			printf("-g needs south,north,west,east,deg and -o Out.h5, without -b\n");
+			return 1;
+		}
+		if (tiepoint_spec != NULL || pyramid_stride > 0) {
+			printf("-g needs whole lat/lon tables, it cannot be used with -T or -p\n");
+			return 1;
+		}
+
+		// Cells are matched through the inverse raster
+		if (raster_cell <= 0) raster_cell = GRID_RASTER_DEG;
+	}
+
+	lookup_region region;
+	if (region_arg != NULL) {
+		if (!parse_region(region_arg, &region) || batch_file != NULL || grid_arg != NULL) {
+			printf("-a needs south,north,west,east or a polygon file of 3 or more \"lat lon\" lines, without -b or -g\n");
+			return 1;
+		}
+		if (tiepoint_spec != NULL || pyramid_stride > 0) {
+			printf("-a needs whole lat/lon tables, it cannot be used with -T or -p\n");
+			return 1;
+		}
+
+		// Pixels are gathered from the raster cells over the region
+		if (raster_cell <= 0) raster_cell = REGION_RASTER_DEG;
+	}
+
+	char* time_table = NULL;
+	double time_window = 0, time_km_per_unit = 0;
+	if (time_spec != NULL) {
+		if (!parse_time_spec(time_spec, &time_table, &time_window, &time_km_per_unit)) {
+			printf("Time search %s is not TimeTable:window{:km_per_unit}\n", time_spec);
+			return 1;
+		}
+		if (tiepoint_spec != NULL || pyramid_stride > 0 || grid_arg != NULL || region_arg != NULL || collocate_arg != NULL) {
+			printf("-t needs whole lat/lon tables and targets, it cannot be used with -T, -p, -g, -a or -C\n");
+			return 1;
+		}
+	}
+
+	char *src_path = NULL, *src_lat_table = NULL, *src_lon_table = NULL;
+	if (collocate_arg != NULL) {
+		if (!parse_collocation_spec(collocate_arg, &src_path, &src_lat_table, &src_lon_table) || grid_file == NULL
+			|| batch_file != NULL || grid_arg != NULL || region_arg != NULL || window_size != 0) {
+			printf("-C needs SourceFile:SourceLatTable:SourceLonTable and -o Out.h5, without -b, -g, -a or -w\n");
+			return 1;
+		}
+		if (tiepoint_spec != NULL || pyramid_stride > 0) {
+			printf("-C needs whole lat/lon tables, it cannot be used with -T or -p\n");
+			return 1;
+		}
+
+		// The target swath is indexed, the source swath queries it
+		if (raster_cell <= 0) raster_cell = COLLOCATE_RASTER_DEG;
+	}
+
+	if (granule_list_file && (tiepoint_spec != NULL || pyramid_stride > 0 || flag_spec != NULL
+		|| grid_arg != NULL || region_arg != NULL || collocate_arg != NULL || window_size != 0)) {
+		printf("-G searches whole lat/lon tables of each granule, it cannot be used with -T, -p, -q, -g, -a, -C or -w\n");
+		return 1;
+	}
+
+	if (orbit_file && (grid_file == NULL || batch_file != NULL || tiepoint_spec != NULL || pyramid_stride > 0 || flag_spec != NULL || raster_cell > 0
+		|| grid_arg != NULL || region_arg != NULL || collocate_arg != NULL || time_spec != NULL || window_size != 0 || granule_list_file)) {
+		printf("-V builds -o Orbit.h5 from a granule list, it cannot be used with other search options\n");
+		return 1;
+	}
+
+	double follow_interval = 0, follow_idle = 0;
+	if (follow_spec != NULL) {
+		if (!parse_follow_spec(follow_spec, &follow_interval, &follow_idle) || batch_file == NULL) {
+			printf("-F needs interval{:idle} seconds and -b targets\n");
+			return 1;
+		}
+		if (tiepoint_spec != NULL || pyramid_stride > 0 || flag_spec != NULL || raster_cell > 0 || image_mb > 0 || grid_arg != NULL
+			|| region_arg != NULL || collocate_arg != NULL || time_spec != NULL || window_size != 0 || granule_list_file || orbit_file) {
+			printf("-F searches rows as they are written, it cannot be used with other search options\n");
+			return 1;
+		}
+	}
+
+	if (watch_dir != NULL && (batch_file != NULL || tiepoint_spec != NULL || pyramid_stride > 0 || flag_spec != NULL || grid_arg != NULL || region_arg != NULL
+		|| collocate_arg != NULL || time_spec != NULL || window_size != 0 || granule_list_file || orbit_file || follow_spec != NULL)) {
+		printf("-D indexes the granules landing in a directory, it cannot be used with other search options\n");
+		return 1;
+	}
+
+	if (io_depth != 0 && (io_depth < 0 || !granule_list_file)) {
+		printf("-A needs a depth of 1 or more and -G\n");
+		return 1;
+	}
+
+	if (readahead != 0 && (readahead < 0 || !granule_list_file)) {
+		printf("-R needs 1 or more granules and -G\n");
+		return 1;
+	}
+
+	if (memo_spec != NULL && (grid_arg != NULL || region_arg != NULL || collocate_arg != NULL || granule_list_file || orbit_file || follow_spec != NULL || watch_dir != NULL)) {
+		printf("-M caches target lookups in one File, it cannot be used with -g, -a, -C, -G, -V, -F or -D\n");
+		return 1;
+	}
+
+	double approx_km = 0;
+	int approx_verify = 0;
+	if (approx_spec != NULL) {
+		if (!parse_approx_spec(approx_spec, &approx_km, &approx_verify)) {
+			printf("-e needs a tolerance of more than 0 km, optionally followed by :verify\n");
+			return 1;
+		}
+		if (tiepoint_spec != NULL || pyramid_stride > 0 || time_spec != NULL || grid_arg != NULL || region_arg != NULL || collocate_arg != NULL
+			|| granule_list_file || orbit_file || follow_spec != NULL || watch_dir != NULL) {
+			printf("-e searches whole lat/lon tables of one File for targets, it cannot be used with -T, -p, -t, -g, -a, -C, -G, -V, -F or -D\n");
+			return 1;
+		}
+
+		// The tolerance prunes raster cells
+		if (raster_cell <= 0) raster_cell = APPROX_RASTER_DEG;
+	}
+
 	char* path = argv[1];
 
-	char** variables = (char**) malloc(sizeof(char*) * (argc - 6));
+	int variable_count = argc - 6;
+	char** variables = (char**) malloc(sizeof(char*) * variable_count);
 	int i;
-	for (i = 0; i < argc - 6; i++) {
+	for (i = 0; i < variable_count; i++) {
 		variables[i] = argv[i + 2];
 	}
 
+	// Orbit file, every table (LatTable and LonTable too) stitched over the granules
+	if (orbit_file) {
+		granule_list* granules = read_granule_list(path);
+		if (granules == NULL || granules->count == 0) {
+			printf("No granules listed in %s\n", path);
+			return 1;
+		}
+
+		if (!build_orbit_file(grid_file, granules, &argv[2], variable_count + 2)) {
+			printf("Unable to write the orbit to %s\n", grid_file);
+			return 1;
+		}
+
+		free_granule_list(granules);
+		free(variables);
+
+		return 0;
+	}
+
 	char* lat_table = argv[argc - 4];
 	char* lon_table = argv[argc - 3];
-	float lat = atof(argv[argc - 2]);
-	float lon = atof(argv[argc - 1]);
+
+	int target_count = 1;
+	lookup_target* targets;
+
+	if (batch_file != NULL) {
+		targets = read_targets(batch_file, &target_count);
+		if (targets == NULL) {
+			printf("Unable to read targets from %s\n", batch_file);
+			return 1;
+		}
+	} else if (grid_arg != NULL || region_arg != NULL || collocate_arg != NULL || watch_dir != NULL) {
+		// Grid cells, the region or the source swath are the targets, handled below
+		target_count = 0;
+		targets = calloc(1, sizeof(lookup_target));
+	} else {
+		targets = calloc(1, sizeof(lookup_target));
+		targets[0].lat = atof(argv[argc - 2]);
+		targets[0].lon = atof(argv[argc - 1]);
+		targets[0].time = target_time != NULL ? atof(target_time) : NAN;
+	}
+
+	// Directory watch, File is the catalog the indexed granules are published to
+	if (watch_dir != NULL) {
+		if (!watch_directory(watch_dir, path, lat_table, lon_table, raster_cell > 0 ? raster_cell : WATCH_RASTER_DEG, threads)) {
+			printf("Unable to watch %s\n", watch_dir);
+			return 1;
+		}
+
+		if (print_stats) print_lookup_stats(stderr);
+
+		free(targets);
+		free(variables);
+
+		return 0;
+	}
+
+	// File still being written, targets are answered as the rows covering them arrive
+	if (follow_spec != NULL) {
+		set_file_swmr_read(1);
+
+		swath_follower* follower = open_follower(path, lat_table, lon_table, target_count, MAX_GOOD_DIS_KM);
+		if (follower == NULL) {
+			printf("Unable to open %s as a SWMR reader of %s and %s\n", path, lat_table, lon_table);
+			return 1;
+		}
+
+		lookup_target* ready = malloc(sizeof(lookup_target) * (target_count > 0 ? target_count : 1));
+		lookup_value* values = malloc(sizeof(lookup_value) * target_count * variable_count);
+		H5T_class_t* data_types = malloc(sizeof(H5T_class_t) * variable_count);
+		int pending = target_count;
+		double idle = 0;
+
+		while (pending > 0) {
+			idle = follow_appended_rows(follower, targets, target_count) > 0 ? 0 : idle + follow_interval;
+
+			int final = idle >= follow_idle;
+			int settled = settle_targets(follower, targets, target_count, final, ready);
+
+			if (settled > 0) {
+				// Rows every 2-d variable has been written for, settled as the matches are. Others
+				// (e.g. a time per scan) have no row extent, a failed read still keeps them pending.
+				int written = follower->rows;
+				for (i = 0; i < variable_count; i++) {
+					int rows = follow_variable_rows(follower, variables[i]);
+					if (rows >= 0 && rows < written) written = rows;
+				}
+
+				int t_i;
+				for (t_i = 0; t_i < target_count; t_i++) {
+					if (ready[t_i].found && ready[t_i].row >= written - FOLLOW_SETTLE_ROWS && !final) {
+						unsettle_target(follower, &ready[t_i], t_i);
+						ready[t_i].found = 0;
+						settled--;
+					}
+				}
+
+				for (i = 0; i < variable_count; i++) {
+					// The variables keep growing, rows scale as the columns do
+					data_types[i] = extract_variable(path, variables[i], ready, target_count, 0, follower->cols, &values[i * target_count]);
+				}
+
+				for (t_i = 0; t_i < target_count; t_i++) {
+					if (!ready[t_i].found) continue;
+
+					// Until the file is done, a value that could not be read is waited for
+					if (ready[t_i].unread && !final) {
+						unsettle_target(follower, &ready[t_i], t_i);
+						settled--;
+						continue;
+					}
+
+					print_target(stdout, &ready[t_i], 0);
+					for (i = 0; i < variable_count; i++) print_value(stdout, &values[i * target_count + t_i], data_types[i]);
+					printf("\n");
+				}
+				fflush(stdout);
+
+				pending -= settled;
+			}
+
+			if (final || pending == 0) break;
+
+			usleep((useconds_t) (follow_interval * 1000000));
+		}
+
+		if (print_stats) print_lookup_stats(stderr);
+
+		close_follower(follower);
+		free(ready);
+		free(values);
+		free(data_types);
+		free(targets);
+		free(variables);
+
+		return 0;
+	}
+
+	// An orbit file (-V) is searched as the granules it stitches, when its lat/lon map them whole
+	granule_list* orbit_granules = NULL;
+	if (!granule_list_file && tiepoint_spec == NULL && pyramid_stride == 0 && flag_spec == NULL && window_size == 0
+		&& grid_arg == NULL && region_arg == NULL && collocate_arg == NULL && memo_spec == NULL && approx_spec == NULL) {
+		orbit_granules = orbit_granule_list(path, lat_table, lon_table);
+	}
+
+	// Virtual swath, File lists the granules searched as one
+	if (granule_list_file || orbit_granules != NULL) {
+		granule_list* granules = orbit_granules != NULL ? orbit_granules : read_granule_list(path);
+		if (granules == NULL || granules->count == 0) {
+			printf("No granules listed in %s\n", path);
+			return 1;
+		}
+
+		// Granules out of a target's time window are never searched for it
+		if (time_table != NULL) {
+			set_granule_times(granules, time_table, time_window, time_km_per_unit);
+			free(time_table);
+		}
+
+		// Variables are read as each granule's targets are located
+		lookup_value* values = malloc(sizeof(lookup_value) * target_count * variable_count);
+		H5T_class_t* data_types = malloc(sizeof(H5T_class_t) * variable_count);
+
+		locate_virtual_swath(granules, lat_table, lon_table, targets, target_count, threads, raster_cell, raster_sidecar, MAX_GOOD_DIS_KM,
+			variables, variable_count, values, data_types, io_depth, readahead);
+
+		stats.targets = target_count;
+		for (i = 0; i < target_count; i++) stats.matches += targets[i].found;
+
+		int t_i;
+		for (t_i = 0; t_i < target_count; t_i++) {
+			if (!targets[t_i].found) continue;
+
+			print_target(stdout, &targets[t_i], time_spec != NULL);
+			for (i = 0; i < variable_count; i++) print_value(stdout, &values[i * target_count + t_i], data_types[i]);
+			printf("\n");
+		}
+
+		stats.file_images = file_image_loads();
+		if (print_stats) print_lookup_stats(stderr);
+
+		free(values);
+		free(data_types);
+		free(targets);
+		free(variables);
+		free_granule_list(granules);
+
+		return 0;
+	}
 	
+	// Cached lines, File is not opened when every target has one
+	memo_cache* memo = NULL;
+	char** memo_lines = NULL;
+	if (memo_spec != NULL) {
+		char options[MEMO_LINE_LEN];
+		snprintf(options, MEMO_LINE_LEN, "T %s p %d q %s r %g t %s w %d W %d z %d e %g",
+			tiepoint_spec != NULL ? tiepoint_spec : "", pyramid_stride, flag_spec != NULL ? flag_spec : "", raster_cell,
+			time_spec != NULL ? time_spec : "", window_size, window_summary, geolocation_packing, approx_km);
+
+		uint64_t query;
+		memo = open_memo_cache(memo_spec);
+		if (memo == NULL || !memo_query_key(path, &argv[2], variable_count + 2, options, &query)) {
+			printf("Unable to cache results of %s in %s\n", path, memo_spec);
+			return 1;
+		}
+
+		memo_lines = memo_lookup(memo, query, targets, target_count);
+
+		int memo_pending = 0;
+		for (i = 0; i < target_count; i++) memo_pending += memo_lines[i] == NULL;
+
+		if (memo_pending == 0) {
+			for (i = 0; i < target_count; i++) {
+				if (*memo_lines[i]) printf("%s\n", memo_lines[i]);
+				free(memo_lines[i]);
+			}
+
+			if (print_stats) print_lookup_stats(stderr);
+
+			free(memo_lines);
+			close_memo_cache(memo);
+			free(targets);
+			free(variables);
+
+			return 0;
+		}
+	}
+
 	/*********/
 
-	char* group_lat_end = strrchr(lat_table, (int) '/');
-	int group_lat_len = group_lat_end - lat_table + 1;
-	char* group_lat = malloc(sizeof(char) * (group_lat_len + 1));
-	strncpy(group_lat, lat_table, group_lat_len);
-	group_lat[group_lat_len] = 0;
-	
-	long name_lat_len = strlen(lat_table) - group_lat_len;
-	char* name_lat = malloc(sizeof(char) * (name_lat_len + 1));
-	strncpy(name_lat, lat_table + group_lat_len, name_lat_len);
-	name_lat[name_lat_len] = 0;
+	char *group_lat, *name_lat;
+	split_table_path(lat_table, &group_lat, &name_lat);
 	
 	/*
 	*/
@@ -211,20 +798,17 @@ int main (int argc, char** argv) {
 	if (DEBUG_HDF5_LOOKUP) printf("lat group: %s\n", group_lat);
 	if (DEBUG_HDF5_LOOKUP) printf("lat name:  %s\n", name_lat);
 	
-	float** data_lat = get_variable_data_by_name_dimalloc2(path, group_lat, name_lat);
+	// Pyramid search reads geolocation piecewise
+	geo_table* data_lat = load_geolocation(path, group_lat, name_lat, threads, pyramid_stride == 0);
+	if (data_lat == NULL) {
+		printf("Unable to read %s as 2-d float, double or integer geolocation\n", lat_table);
+		return 1;
+	}
 
 	/*********/	
 
-	char* group_lon_end = strrchr(lon_table, (int) '/');
-	int group_lon_len = group_lon_end - lon_table + 1;
-	char* group_lon = malloc(sizeof(char) * (group_lon_len + 1));
-	strncpy(group_lon, lon_table, group_lon_len);
-	group_lon[group_lon_len] = 0;
-	
-	long name_lon_len = strlen(lon_table) - group_lon_len;
-	char* name_lon = malloc(sizeof(char) * (name_lon_len + 1));
-	strncpy(name_lon, lon_table + group_lon_len, name_lon_len);
-	name_lon[name_lon_len] = 0;
+	char *group_lon, *name_lon;
+	split_table_path(lon_table, &group_lon, &name_lon);
 
 	/*
 	*/
@@ -232,10 +816,16 @@ int main (int argc, char** argv) {
 	if (DEBUG_HDF5_LOOKUP) printf("lon group: %s\n", group_lon);
 	if (DEBUG_HDF5_LOOKUP) printf("lon name:  %s\n", name_lon);
 	
-	float** data_lon = get_variable_data_by_name_dimalloc2(path, group_lon, name_lon);
+	geo_table* data_lon = load_geolocation(path, group_lon, name_lon, threads, pyramid_stride == 0);
+	if (data_lon == NULL) {
+		printf("Unable to read %s as 2-d float, double or integer geolocation\n", lon_table);
+		return 1;
+	}
 	
 	size_t *ll_dims = (size_t*) get_variable_dims_by_name(path, group_lon, name_lon);
 
+	if (pyramid_stride == 0) stats.geolocation_elements += 2 * ll_dims[0] * ll_dims[1];
+
 	/*********/
 	
 	if (DEBUG_HDF5_LOOKUP) printf("Finding target\n");
@@ -243,146 +833,307 @@ int main (int argc, char** argv) {
 	int rows = ll_dims[0];
 	int cols = ll_dims[1];
 
-	int* indices = (int*) get_indices_from_lat_long(data_lat, data_lon, lat, lon, rows, cols);
+	if (data_lat->rows != data_lon->rows || data_lat->cols != data_lon->cols) {
+		printf("%s and %s differ in extent\n", lat_table, lon_table);
+		return 1;
+	}
+
+	// Fill values are resolved once, the searches test packed bits
+	validity_mask* mask = NULL;
+	if (pyramid_stride == 0) {
+		mask = build_validity_mask(data_lat, data_lon);
+		stats.geolocation_valid = mask->valid;
+	}
+
+	geolocation geo = { path, group_lat, name_lat, group_lon, name_lon, rows, cols, data_lat, data_lon, mask };
+	tiepoint_grid tp;
+	pyramid_search ps = { path, group_lat, name_lat, group_lon, name_lon, rows, cols };
+	ps.t_lat = data_lat;
+	ps.t_lon = data_lon;
+
+	if (tiepoint_spec != NULL) {
+
+		// Search the tie-point grid, geolocation takes the resolution of the first variable
+		char *group_res, *name_res;
+		split_table_path(variables[0], &group_res, &name_res);
+
+		free(ll_dims);
+		ll_dims = (size_t*) get_variable_dims_by_name(path, group_res, name_res);
+
+		free(group_res);
+		free(name_res);
+
+		if (!parse_tiepoint_spec(tiepoint_spec, &tp) || !set_tiepoint_dims(&tp, ll_dims[0], ll_dims[1], rows, cols)) {
+			printf("Tie-point layout %s does not match %s (%d x %d) to %s (%d x %d)\n",
+				tiepoint_spec, lat_table, rows, cols, variables[0], (int) ll_dims[0], (int) ll_dims[1]);
+			return 1;
+		}
+
+		tp.tie_lat = data_lat;
+		tp.tie_lon = data_lon;
+		tp.tie_mask = mask;
+
+		geo.tp = &tp;
+		geo.rows = ll_dims[0];
+		geo.cols = ll_dims[1];
+	} else if (pyramid_stride > 0) {
+		geo.ps = &ps;
+		geo.pyramid_stride = pyramid_stride;
+	}
 	
-	// TODO add handling for float/double of lat/lon
+	// Quality flags at the search resolution, tested by every search mode
+	validity_mask* flag_mask = NULL;
+	if (flag_spec != NULL) {
+		char* flag_table;
+		unsigned long long flag_bits, flag_value;
+
+		if (!parse_flag_spec(flag_spec, &flag_table, &flag_bits, &flag_value)) {
+			printf("Quality flag condition %s is not FlagTable:mask:value\n", flag_spec);
+			return 1;
+		}
 
-	int row = indices[0];
-	int col = indices[1];
+		char *group_flag, *name_flag;
+		split_table_path(flag_table, &group_flag, &name_flag);
 
-	/*********/
+		flag_mask = build_flag_mask(path, group_flag, name_flag, flag_bits, flag_value);
 
-	if ((row >= 0 && row < rows) && (col >= 0 && col < cols)) {
-		float latitude = data_lat[row][col];
-		float longitude = data_lon[row][col];
-		double distance = gc_distance(latitude, longitude, lat, lon);
-		
-		if (DEBUG_HDF5_LOOKUP) printf("%f %f %f\n", latitude, longitude, distance);
-		
-		if (distance < MAX_GOOD_DIS_KM) {
-
-			printf("%10.6f %10.6f %6.4f %10.6f %10.6f",
-				lat,
-				lon,
-				distance,
-				data_lat[row][col],
-				data_lon[row][col]);
-			
-			for (i = 0; i < argc - 6; i++) {
-			
-				char* dat_table = variables[i];
-				
-				char* group_dat_end = strrchr(dat_table, (int) '/');
-				int group_dat_len = group_dat_end - dat_table + 1;
-				char* group_dat = malloc(sizeof(char) * (group_dat_len + 1));
-				strncpy(group_dat, dat_table, group_dat_len);
-				group_dat[group_dat_len] = 0;
-				
-				long name_dat_len = strlen(dat_table) - group_dat_len;
-				char* name_dat = malloc(sizeof(char) * (name_dat_len + 1));
-				strncpy(name_dat, dat_table + group_dat_len, name_dat_len);
-				name_dat[name_dat_len] = 0;
-				
-				/*
-				*/
-				if (DEBUG_HDF5_LOOKUP) printf("dat path:  %s\n", path);
-				if (DEBUG_HDF5_LOOKUP) printf("dat group: %s\n", group_dat);
-				if (DEBUG_HDF5_LOOKUP) printf("dat name:  %s\n", name_dat);
-				
-				H5T_class_t data_type = get_variable_type_by_name(path, group_dat, name_dat);
-				size_t *dims = (size_t*) get_variable_dims_by_name(path, group_dat, name_dat);
-				
-				unsigned long* data_lng;
-				float** data_flt;
-				
-				if (DEBUG_HDF5_LOOKUP) printf("data_type is: %d %d %d\n", data_type, H5T_INTEGER, H5T_FLOAT);
-				
-				if (data_type == H5T_INTEGER) {				
-					data_lng = get_variable_data_by_name_dimalloc(path, group_dat, name_dat);
-				} else if (data_type == H5T_FLOAT) {
-					data_flt = get_variable_data_by_name_dimalloc2(path, group_dat, name_dat);
-				}
-				
-				if (DEBUG_HDF5_LOOKUP) printf(" %d %d %d\n", (int) dims[0], (int) dims[1], (int) dims[2]);
-				
-				/*
-				int x, y;
-				
-				for(y = 0; y < rows; y++) { 			// rows
-					for(x = 0; x < cols; x++) {			// columns
-					
-						float lat = data_lat[x][y];
-						float lon = data_lon[x][y];
-						float dat = data_dat[x][y];
-						
-						if ((lat > -9999) && (lon > -9999) & (dat > -9999)) {
-							
-							printf("%4.10f %4.10f %4.10f\n", lat, lon, dat);
-						}
-					}
-				}
-				*/
-				
-				int ll_row = row;
-				int ll_col = col;
-				
-				int row_count = dims[0];
-				int col_count = dims[1];
-				if (DEBUG_HDF5_LOOKUP) printf(" r c = %d %d\n", row_count, col_count);
-				
-				int ll_row_count = ll_dims[0];
-				int ll_col_count = ll_dims[1];
-				if (DEBUG_HDF5_LOOKUP) printf(" r c = %d %d\n", ll_row_count, ll_col_count);
-				
-				free(dims);
-				
-				int new_row = (int) ((float) ll_row * ((float) row_count / (float) ll_row_count));
-				int new_col = (int) ((float) ll_col * ((float) col_count / (float) ll_col_count));
-
-				if (DEBUG_HDF5_LOOKUP) printf(" r c = %d %d\n", new_row, new_col);
-
-				if (data_type == H5T_INTEGER) {				
-					//unsigned long data_out = data_lng[new_row][new_col];
-					unsigned long data_out = data_lng[new_row];
-					printf(" %lu", data_out);
-				} else if (data_type == H5T_FLOAT) {
-					float data_out = data_flt[new_row][new_col];
-					printf(" %f", data_out);
-				}
-				//printf("target lat,lon[%10.6f, %10.6f] is [%6.4f] km to x,y[%4d, %4d] = lat,lon[%10.6f, %10.6f] => val %e \n",
-
-				// write target data to stdout
-				//printf(" %15.13e\n", (double) data_out);
-				
-				free(group_dat);
-				free(name_dat);
-				
-				if (data_type == H5T_INTEGER) {				
-					free(data_lng);
-				} else if (data_type == H5T_FLOAT) {
-					free(data_flt);
-				}
-				
-				//free(data_dat);
+		if (flag_mask == NULL || flag_mask->rows != geo.rows || flag_mask->cols != geo.cols) {
+			printf("Quality flags %s do not match the search resolution (%d x %d)\n", flag_table, geo.rows, geo.cols);
+			return 1;
+		}
+
+		stats.flag_passed = flag_mask->valid;
+
+		if (geo.tp != NULL) {
+			tp.flag_mask = flag_mask;
+		} else if (geo.ps != NULL) {
+			ps.flag_mask = flag_mask;
+		} else {
+			and_validity_mask(mask, flag_mask);
+			stats.geolocation_valid = mask->valid;
+		}
+
+		free(flag_table);
+		free(group_flag);
+		free(name_flag);
+	}
+
+	// Scan times, each target's time window becomes row penalties for the search
+	scan_times* times = NULL;
+	if (time_table != NULL) {
+		char *group_time, *name_time;
+		split_table_path(time_table, &group_time, &name_time);
+
+		times = read_scan_times(path, group_time, name_time, geo.rows);
+		if (times == NULL) {
+			printf("%s is not a 1-d time per scan of %s (%d rows)\n", time_table, lat_table, geo.rows);
+			return 1;
+		}
+
+		times->window = time_window;
+		times->km_per_unit = time_km_per_unit;
+
+		free(group_time);
+		free(name_time);
+		free(time_table);
+	}
+
+	// Inverse raster over the final mask, from the sidecar file when it is current
+	inverse_raster* raster = NULL;
+	if (raster_cell > 0) {
+		if (geo.tp != NULL || geo.ps != NULL) {
+			printf("-r needs whole lat/lon tables, it cannot be used with -T or -p\n");
+			return 1;
+		}
+
+		int cached;
+		raster = granule_raster(path, lat_table, lon_table, flag_spec, raster_cell, data_lat, data_lon, mask, threads, raster_sidecar, &cached);
+		if (raster == NULL) {
+			printf("Unable to build a %g degree raster for %s\n", raster_cell, lat_table);
+			return 1;
+		}
+
+		stats.raster_cached = cached;
+
+		raster->search_km = MAX_GOOD_DIS_KM;
+		stats.raster_cells = raster->nlat * raster->nlon;
+		geo.raster = raster;
+		geo.tolerance_km = approx_km;
+	}
+
+	if (grid_arg != NULL && !grid_swath(grid_file, &grid, &geo, path, variables, variable_count, threads)) {
+		printf("Unable to write the grid to %s\n", grid_file);
+		return 1;
+	}
+
+	if (collocate_arg != NULL) {
+		if (!collocate_swath(grid_file, src_path, src_lat_table, src_lon_table, &geo, path, variables, variable_count, threads)) {
+			printf("Unable to write the collocation to %s\n", grid_file);
+			return 1;
+		}
+
+		free(src_path);
+		free(src_lat_table);
+		free(src_lon_table);
+	}
+
+	// One line per variable: table count mean stddev min max
+	if (region_arg != NULL) {
+		int pixel_count;
+		int* pixels = region_pixels(raster, data_lat, data_lon, &region, &pixel_count);
+		stats.region_pixels = pixel_count;
+
+		for (i = 0; i < variable_count; i++) {
+			region_stats result;
+			if (!aggregate_variable(path, variables[i], &geo, pixels, pixel_count, threads, &result)) {
+				printf("Unable to aggregate %s, 2-d integer or float variables only\n", variables[i]);
+				return 1;
 			}
-			//for each variable
-			// cycle through data out values as columns on stdout
-			printf("\n");
+
+			if (result.count == 0) {
+				printf("%s 0 nan nan nan nan\n", variables[i]);
+				continue;
+			}
+
+			printf("%s %lu %f %f %f %f\n",
+				variables[i],
+				(unsigned long) result.count,
+				result.mean,
+				result.count > 1 ? sqrt(result.m2 / (result.count - 1)) : 0.,
+				result.min,
+				result.max);
+		}
+
+		free(pixels);
+		free_region(&region);
+	}
+
+	// Search in spatial order, results stay in input order
+	int* plan = plan_targets_hilbert(targets, target_count);
+
+	for (i = 0; i < target_count; i++) {
+		lookup_target* t = &targets[plan[i]];
+
+		if (memo_lines != NULL && memo_lines[plan[i]] != NULL) continue;
+
+		if (times != NULL) geo.row_penalty = scan_penalty(times, t->time);
+
+		t->found = locate_pixel(&geo, t->lat, t->lon, &t->row, &t->col, &t->obs_lat, &t->obs_lon);
+
+		if (t->found) {
+			t->distance = gc_distance(t->obs_lat, t->obs_lon, t->lat, t->lon);
+			if (times != NULL) t->obs_time = times->time[t->row / times->rows_per_scan];
+
+			if (DEBUG_HDF5_LOOKUP) printf("%f %f %f\n", t->obs_lat, t->obs_lon, t->distance);
+		}
+
+		// The approximate result, before the match cut, against the brute force search of the same pixels
+		if (approx_verify) verify_approximate(&geo, t->lat, t->lon, t->found, t->found ? t->distance : 0, MAX_GOOD_DIS_KM);
+
+		// Only matches are worth reading variables for
+		if (t->found && t->distance >= MAX_GOOD_DIS_KM) t->found = 0;
+
+		stats.targets++;
+		if (t->found) stats.matches++;
+	}
+
+	free(plan);
+
+	if (raster != NULL) stats.raster_visited = raster->visited;
+
+	/*********/
+
+	// Read each variable once for all of the targets
+	lookup_value* values = malloc(sizeof(lookup_value) * target_count * variable_count);
+	H5T_class_t* data_types = malloc(sizeof(H5T_class_t) * variable_count);
+
+	for (i = 0; i < variable_count && target_count > 0 && window_size == 0; i++) {
+		data_types[i] = extract_variable(path, variables[i], targets, target_count, geo.rows, geo.cols, &values[i * target_count]);
+	}
+
+	// Or a window per variable and target, one hyperslab read each
+	int window_area = window_size * window_size;
+	double* windows = malloc(sizeof(double) * target_count * variable_count * window_area + 1);
+	window_variable* window_info = malloc(sizeof(window_variable) * variable_count);
+
+	for (i = 0; i < variable_count && target_count > 0 && window_size > 0; i++) {
+		if (!extract_windows(path, variables[i], targets, target_count, geo.rows, geo.cols, window_size, &windows[(size_t) i * target_count * window_area], &window_info[i])) {
+			printf("Unable to read windows of %s, 2-d integer or float variables only\n", variables[i]);
+			return 1;
 		}
 	}
+
 	// Return the requested variables as series of columns
+	int t_i;
+	for (t_i = 0; t_i < target_count; t_i++) {
+		lookup_target* t = &targets[t_i];
+
+		// Cached, or no match ("" in the cache)
+		if (memo_lines != NULL && memo_lines[t_i] != NULL) {
+			if (*memo_lines[t_i]) printf("%s\n", memo_lines[t_i]);
+			free(memo_lines[t_i]);
+			continue;
+		}
+
+		if (!t->found) {
+			if (memo != NULL) memo_store(memo, t, "");
+			continue;
+		}
+
+		// Lines for the cache are written to memory first
+		char* line = NULL;
+		size_t line_length = 0;
+		FILE* fp = memo != NULL ? open_memstream(&line, &line_length) : stdout;
+
+		print_target(fp, t, times != NULL);
+
+		for (i = 0; i < variable_count; i++) {
+			if (window_size > 0) {
+				print_window(fp, &windows[((size_t) i * target_count + t_i) * window_area], window_size, &window_info[i], window_summary);
+			} else {
+				print_value(fp, &values[i * target_count + t_i], data_types[i]);
+			}
+		}
+
+		if (memo != NULL) {
+			fclose(fp);
+			memo_store(memo, t, line);
+			fputs(line, stdout);
+			free(line);
+		}
+		printf("\n");
+	}
 	
-	free(indices);
+	stats.file_images = file_image_loads();
+	if (print_stats) print_lookup_stats(stderr);
+
+	if (approx_verify && stats.approx_violations > 0) {
+		fprintf(stderr, "%lu of %lu approximate results are more than %g km beyond the nearest pixel\n",
+			(unsigned long) stats.approx_violations, (unsigned long) stats.approx_verified, approx_km);
+	}
+
+	free(values);
+	free(data_types);
+	free(windows);
+	free(window_info);
+	free(targets);
+	free(ll_dims);
 
 	free(group_lat);
 	free(name_lat);
-	free(data_lat);
+	free_geolocation(data_lat);
 	
 	free(group_lon);
 	free(name_lon);
-	free(data_lon);
+	free_geolocation(data_lon);
+	free_validity_mask(mask);
+	free_validity_mask(flag_mask);
+	free_inverse_raster(raster);
+	free_scan_times(times);
+	free(memo_lines);
+	close_memo_cache(memo);
 	
 	free(variables);
 	
-	return 0;
+	return approx_verify && stats.approx_violations > 0;
 }
@@ -11,6 +11,7 @@
  *
  *	Modifications:
  *		2021 04 27 - Initial Version
+ *		2026 10 18 - Added lookup modules (hdf5_lookup.src)
  *
  */
  
@@ -18,4 +19,35 @@
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <unistd.h>
 #include "hdf5_helper.src/hdf5_helper.c"
+#include "hdf5_helper.src/hdf5_direct.c"
+#include "hdf5_helper.src/hdf5_mmap.c"
+#include "hdf5_helper.src/hdf5_advise.c"
+
+double gc_distance(double lat_0, double lon_0, double lat_1, double lon_1);
+void split_table_path(const char* table, char** group, char** name);
+
+#include "hdf5_lookup.src/stats.c"
+#include "hdf5_lookup.src/packed.c"
+#include "hdf5_lookup.src/geotable.c"
+#include "hdf5_lookup.src/validity.c"
+#include "hdf5_lookup.src/nearest.c"
+#include "hdf5_lookup.src/scantime.c"
+#include "hdf5_lookup.src/raster.c"
+#include "hdf5_lookup.src/tiepoint.c"
+#include "hdf5_lookup.src/pyramid.c"
+#include "hdf5_lookup.src/geolocation.c"
+#include "hdf5_lookup.src/approx.c"
+#include "hdf5_lookup.src/batch.c"
+#include "hdf5_lookup.src/memo.c"
+#include "hdf5_lookup.src/extract.c"
+#include "hdf5_lookup.src/window.c"
+#include "hdf5_lookup.src/pipeline.c"
+#include "hdf5_lookup.src/virtual.c"
+#include "hdf5_lookup.src/orbit.c"
+#include "hdf5_lookup.src/follow.c"
+#include "hdf5_lookup.src/watch.c"
+#include "hdf5_lookup.src/grid.c"
+#include "hdf5_lookup.src/collocate.c"
+#include "hdf5_lookup.src/region.c"
@@ -0,0 +1,90 @@
+/*
+ *	Program: HDF5 Lookup v0.1
+ *
+ *	Usage: This code is free to use and modify, so long
+ *		as this header remains intact, except for
+ *		"Modifications" below.
+ *
+ *	Purpose: Approximate search (-e km{:verify}), the raster search
+ *		(raster.c, default cell APPROX_RASTER_DEG) allowed to return a
+ *		pixel up to km further from the target than the nearest one.
+ *
+ *		Cells that could only improve on the best pixel so far by less
+ *		than km are never visited, and the search stops at the first
+ *		pixel within km of the target. For every target the bound
+ *		actually achieved is the best distance less the lowest bound of
+ *		the cells left, never more than km and 0 when nothing was left;
+ *		the largest over the targets is reported by -s (approx bound km).
+ *
+ *		With :verify every target is searched again by brute force over
+ *		the same tables and mask, and a result more than km further than
+ *		the nearest pixel (or missing while the nearest is a match) is
+ *		reported on stderr and counted (approx violations), making the
+ *		run fail. The largest excess over the nearest is reported as
+ *		approx error km.
+ *
+ *	Functions
+ *		int			parse_approx_spec	- tolerance and verify flag of -e
+ *		int			verify_approximate	- 1 when a result keeps to the tolerance
+ *
+ *	Modifications:
+ *		2026 10 18 - Initial Version
+ */
+
+#define DEBUG_APPROX 0
+
+#define APPROX_RASTER_DEG 0.05		// -r default with -e
+#define APPROX_SLACK_KM 1e-9		// rounding allowed by the check
+
+int parse_approx_spec(const char* spec, double* tolerance_km, int* verify) {
+
+	char* end;
+	*tolerance_km = strtod(spec, &end);
+	if (end == spec || !(*tolerance_km > 0)) return 0;
+
+	*verify = 0;
+	if (*end == ':') {
+		if (strcmp(end + 1, "verify") != 0) return 0;
+		*verify = 1;
+	} else if (*end != 0) {
+		return 0;
+	}
+
+	return 1;
+}
+
+// found/distance are the approximate result before any MAX_GOOD_DIS_KM cut
+int verify_approximate(geolocation* geo, float target_lat, float target_lon, int found, double distance, double max_km) {
+
+	int* indices = (int*) get_indices_from_geo_tables(geo->data_lat, geo->data_lon, geo->mask, target_lat, target_lon);
+	int row = indices[0];
+	int col = indices[1];
+	free(indices);
+
+	stats.approx_verified++;
+
+	// No valid pixel at all, nothing to miss
+	if (!(row >= 0 && row < geo->rows && col >= 0 && col < geo->cols)) return 1;
+
+	double nearest = gc_distance(geo_value(geo->data_lat, row, col), geo_value(geo->data_lon, row, col), target_lat, target_lon);
+
+	int ok;
+	if (found) {
+		double error = distance - nearest;
+		if (error > stats.approx_error_km) stats.approx_error_km = error;
+		ok = error <= geo->tolerance_km + APPROX_SLACK_KM;
+	} else {
+		// The raster search returns pixels up to max_km
+		ok = nearest > max_km;
+	}
+
+	if (DEBUG_APPROX) printf("approx %f %f: %f km, nearest %f km\n", target_lat, target_lon, found ? distance : NAN, nearest);
+
+	if (!ok) {
+		stats.approx_violations++;
+		fprintf(stderr, "Approximate result for %f %f is %f km, the nearest pixel (%d, %d) is %f km\n",
+			target_lat, target_lon, found ? distance : NAN, row, col, nearest);
+	}
+
+	return ok;
+}
@@ -0,0 +1,174 @@
+/*
+ *	Program: HDF5 Lookup v0.1
+ *
+ *	Usage: This code is free to use and modify, so long
+ *		as this header remains intact, except for
+ *		"Modifications" below.
+ *
+ *	Purpose: Batch targets (-b file) and the order they are executed in.
+ *
+ *		Targets are read one "lat lon" pair per line ('#' starts a
+ *		comment, "-" reads standard input), optionally followed by a
+ *		time for time aware searches (-t). Execution follows a plan,
+ *		an array of target indices, so results stay in the targets
+ *		array in input order and are written back out in that order.
+ *
+ *		plan_targets_hilbert orders the targets along a Hilbert curve
+ *		over their bounding box, so consecutive searches touch the same
+ *		part of the granule (and the same geolocation chunks).
+ *
+ *	Functions
+ *		lookup_target*	read_targets			- returns count targets from a file
+ *		unsigned long	hilbert_index			- distance along the curve of x,y in [0, HILBERT_SIDE)
+ *		int*			plan_targets_hilbert	- returns an execution order for the targets
+ *		int*			plan_by_key				- returns indices sorted by key (ties keep input order)
+ *
+ *	Modifications:
+ *		2026 10 18 - Initial Version
+ *		2026 10 18 - Optional target time
+ */
+
+#define DEBUG_BATCH 0
+
+#define HILBERT_SIDE 65536
+#define TARGET_LINE_LEN 1024
+
+typedef struct {
+	float lat;					// target, as given
+	float lon;
+	int found;					// 1 once located in the geolocation
+	int row;					// geolocation row/col of the nearest pixel
+	int col;
+	double obs_lat;
+	double obs_lon;
+	double distance;
+	double time;				// target time, NAN when not given
+	double obs_time;			// scan time of the located pixel (-t)
+	int granule;				// granule of the located pixel (-G)
+	int unread;					// 1 when a variable could not be read at the pixel
+} lookup_target;
+
+typedef struct {
+	unsigned long key;
+	int index;
+} plan_entry;
+
+lookup_target* read_targets(const char* file, int* count) {
+
+	FILE* fp = strcmp(file, "-") == 0 ? stdin : fopen(file, "r");
+
+	*count = 0;
+	if (fp == NULL) return NULL;
+
+	int allocated = 1024;
+	lookup_target* targets = malloc(sizeof(lookup_target) * allocated);
+
+	char line[TARGET_LINE_LEN];
+	while (fgets(line, TARGET_LINE_LEN, fp) != NULL) {
+
+		char* comment = strchr(line, '#');
+		if (comment != NULL) *comment = 0;
+
+		float lat, lon;
+		double time;
+		int fields = sscanf(line, "%f %f %lf", &lat, &lon, &time);
+		if (fields < 2) continue;
+
+		if (*count == allocated) {
+			allocated *= 2;
+			targets = realloc(targets, sizeof(lookup_target) * allocated);
+		}
+
+		memset(&targets[*count], 0, sizeof(lookup_target));
+		targets[*count].lat = lat;
+		targets[*count].lon = lon;
+		targets[*count].time = fields == 3 ? time : NAN;
+		(*count)++;
+	}
+
+	if (fp != stdin) fclose(fp);
+
+	if (DEBUG_BATCH) printf("read %d targets from %s\n", *count, file);
+
+	return targets;
+}
+
+int compare_plan_entry(const void* a, const void* b) {
+	const plan_entry* pa = (const plan_entry*) a;
+	const plan_entry* pb = (const plan_entry*) b;
+	if (pa->key != pb->key) return pa->key < pb->key ? -1 : 1;
+	return pa->index - pb->index;
+}
+
+int* plan_by_key(unsigned long* keys, int count) {
+
+	plan_entry* entries = malloc(sizeof(plan_entry) * count);
+	int i;
+	for (i = 0; i < count; i++) {
+		entries[i].key = keys[i];
+		entries[i].index = i;
+	}
+
+	qsort(entries, count, sizeof(plan_entry), compare_plan_entry);
+
+	int* plan = malloc(sizeof(int) * count);
+	for (i = 0; i < count; i++) plan[i] = entries[i].index;
+
+	free(entries);
+	return plan;
+}
+
+unsigned long hilbert_index(unsigned int x, unsigned int y) {
+
+	unsigned long d = 0;
+	unsigned int s;
+
+	for (s = HILBERT_SIDE / 2; s > 0; s /= 2) {
+		unsigned int rx = (x & s) > 0;
+		unsigned int ry = (y & s) > 0;
+
+		d += (unsigned long) s * s * ((3 * rx) ^ ry);
+
+		// rotate the quadrant so the curve stays continuous
+		if (ry == 0) {
+			if (rx == 1) {
+				x = HILBERT_SIDE - 1 - x;
+				y = HILBERT_SIDE - 1 - y;
+			}
+			unsigned int t = x;
+			x = y;
+			y = t;
+		}
+	}
+
+	return d;
+}
+
+int* plan_targets_hilbert(lookup_target* targets, int count) {
+
+	float lat_min = 90, lat_max = -90, lon_min = 180, lon_max = -180;
+	int i;
+
+	for (i = 0; i < count; i++) {
+		if (targets[i].lat < lat_min) lat_min = targets[i].lat;
+		if (targets[i].lat > lat_max) lat_max = targets[i].lat;
+		if (targets[i].lon < lon_min) lon_min = targets[i].lon;
+		if (targets[i].lon > lon_max) lon_max = targets[i].lon;
+	}
+
+	double lat_span = lat_max > lat_min ? lat_max - lat_min : 1.;
+	double lon_span = lon_max > lon_min ? lon_max - lon_min : 1.;
+
+	unsigned long* keys = malloc(sizeof(unsigned long) * count);
+
+	for (i = 0; i < count; i++) {
+		unsigned int x = (unsigned int) ((targets[i].lon - lon_min) / lon_span * (HILBERT_SIDE - 1));
+		unsigned int y = (unsigned int) ((targets[i].lat - lat_min) / lat_span * (HILBERT_SIDE - 1));
+		keys[i] = hilbert_index(x, y);
+	}
+
+	int* plan = plan_by_key(keys, count);
+
+	free(keys);
+	return plan;
+}
@@ -0,0 +1,203 @@
+/*
+ *	Program: HDF5 Lookup v0.1
+ *
+ *	Usage: This code is free to use and modify, so long
+ *		as this header remains intact, except for
+ *		"Modifications" below.
+ *
+ *	Purpose: Swath to swath collocation (-C SourceFile:LatTable:LonTable
+ *		-o Out.h5). Every valid pixel of the source swath, e.g. VIIRS
+ *		M-band, is matched with the nearest valid pixel of the target
+ *		swath (File LatTable LonTable, e.g. DNB) within MAX_GOOD_DIS_KM.
+ *
+ *		The target swath is indexed once in the inverse raster (raster.c,
+ *		-r, default COLLOCATE_RASTER_DEG). Source rows are handed out to
+ *		the -j threads in blocks of COLLOCATE_ROWS, and along a row each
+ *		query is warm started from the match of the pixel before (the
+ *		pixel above at the start of a row). Consecutive pixels are a
+ *		pixel apart on the ground, so the previous match bounds the search
+ *		to the first ring or two of raster cells. The warm start only
+ *		prunes, the match is the same as a cold search, ties included.
+ *
+ *	Output (Out.h5, overwritten), at the source resolution:
+ *		pixel_row, pixel_col	target swath pixel of each source pixel, -1 if none
+ *		distance				km between the two
+ *		Name					each target variable gathered to the source pixels,
+ *								as for -g (see grid.c)
+ *
+ *	Functions
+ *		int			parse_collocation_spec	- file and tables of -C
+ *		int			collocate_swath			- match the source pixels and write the output file
+ *
+ *	Modifications:
+ *		2026 10 18 - Initial Version
+ */
+
+#define DEBUG_COLLOCATE 0
+
+#define COLLOCATE_ROWS 16
+#define COLLOCATE_RASTER_DEG 0.05		// -r default in collocation mode
+
+typedef struct {
+	geolocation* geo;			// target swath, with its raster
+	geo_table* src_lat;
+	geo_table* src_lon;
+	validity_mask* src_mask;
+	int* pixel;					// per source pixel, target row * cols + col or -1
+	float* distance;
+	int next_row;				// shared, under lock
+	pthread_mutex_t lock;
+	size_t visited;				// summed from the workers, under lock
+} collocate_job;
+
+// Fills file/lat_table/lon_table (new strings) from File:LatTable:LonTable
+int parse_collocation_spec(const char* spec, char** file, char** lat_table, char** lon_table) {
+
+	const char* lon_sep = strrchr(spec, ':');
+	if (lon_sep == NULL || lon_sep == spec) return 0;
+
+	const char* lat_sep = lon_sep - 1;
+	while (lat_sep > spec && *lat_sep != ':') lat_sep--;
+	if (lat_sep == spec || lon_sep - lat_sep < 2 || lon_sep[1] == 0) return 0;
+
+	*file = strndup(spec, lat_sep - spec);
+	*lat_table = strndup(lat_sep + 1, lon_sep - lat_sep - 1);
+	*lon_table = strdup(lon_sep + 1);
+
+	return 1;
+}
+
+void* collocate_worker(void* arg) {
+
+	collocate_job* job = (collocate_job*) arg;
+	geolocation* geo = job->geo;
+	int rows = job->src_mask->rows;
+	int cols = job->src_mask->cols;
+	size_t visited = 0;
+
+	while (1) {
+		pthread_mutex_lock(&job->lock);
+		int row0 = job->next_row;
+		job->next_row += COLLOCATE_ROWS;
+		pthread_mutex_unlock(&job->lock);
+
+		if (row0 >= rows) break;
+
+		int row1 = row0 + COLLOCATE_ROWS < rows ? row0 + COLLOCATE_ROWS : rows;
+
+		int row, col;
+		for (row = row0; row < row1; row++) {
+			int hint = -1;
+
+			for (col = 0; col < cols; col++) {
+				size_t index = (size_t) row * cols + col;
+
+				job->pixel[index] = -1;
+				job->distance[index] = -999.;
+
+				if (!validity_test(job->src_mask, row, col)) continue;
+
+				// The pixel before, or above when starting a row
+				if (hint < 0 && row > row0) hint = job->pixel[index - cols];
+
+				double closest;
+				int match = raster_nearest(geo->raster, geo->data_lat, geo->data_lon,
+					geo_value(job->src_lat, row, col), geo_value(job->src_lon, row, col), hint, NULL, &closest, &visited);
+
+				job->pixel[index] = match;
+				if (match >= 0) job->distance[index] = closest;
+
+				hint = match;
+			}
+		}
+	}
+
+	pthread_mutex_lock(&job->lock);
+	job->visited += visited;
+	pthread_mutex_unlock(&job->lock);
+
+	return NULL;
+}
+
+int collocate_swath(const char* out, const char* src_path, const char* src_lat_table, const char* src_lon_table, geolocation* geo, const char* path, char** variables, int variable_count, int threads) {
+
+	char *group_lat, *name_lat, *group_lon, *name_lon;
+	split_table_path(src_lat_table, &group_lat, &name_lat);
+	split_table_path(src_lon_table, &group_lon, &name_lon);
+
+	geo_table* src_lat = load_geolocation(src_path, group_lat, name_lat, threads, 1);
+	geo_table* src_lon = load_geolocation(src_path, group_lon, name_lon, threads, 1);
+
+	free(group_lat);
+	free(name_lat);
+	free(group_lon);
+	free(name_lon);
+
+	if (src_lat == NULL || src_lon == NULL || src_lat->rows != src_lon->rows || src_lat->cols != src_lon->cols) {
+		fprintf(stderr, "%s and %s of %s are not matching 2-d geolocation\n", src_lat_table, src_lon_table, src_path);
+		free_geolocation(src_lat);
+		free_geolocation(src_lon);
+		return 0;
+	}
+
+	int rows = src_lat->rows;
+	int cols = src_lat->cols;
+	size_t pixels = (size_t) rows * cols, index;
+
+	collocate_job job;
+	memset(&job, 0, sizeof(collocate_job));
+	job.geo = geo;
+	job.src_lat = src_lat;
+	job.src_lon = src_lon;
+	job.src_mask = build_validity_mask(src_lat, src_lon);
+	job.pixel = malloc(sizeof(int) * pixels);
+	job.distance = malloc(sizeof(float) * pixels);
+	pthread_mutex_init(&job.lock, NULL);
+
+	int blocks = (rows + COLLOCATE_ROWS - 1) / COLLOCATE_ROWS;
+	if (threads < 1) threads = 1;
+	if (threads > blocks) threads = blocks > 0 ? blocks : 1;
+
+	pthread_t* workers = malloc(sizeof(pthread_t) * threads);
+	int t;
+	for (t = 0; t < threads; t++) pthread_create(&workers[t], NULL, collocate_worker, &job);
+	for (t = 0; t < threads; t++) pthread_join(workers[t], NULL);
+	free(workers);
+
+	pthread_mutex_destroy(&job.lock);
+
+	geo->raster->visited += job.visited;
+
+	stats.collocate_pixels = job.src_mask->valid;
+	for (index = 0; index < pixels; index++) {
+		if (job.pixel[index] >= 0) stats.collocate_matched++;
+	}
+
+	if (DEBUG_COLLOCATE) printf("collocate %s %d x %d on %d threads: %lu valid, %lu matched, %lu visited\n",
+		src_path, rows, cols, threads, (unsigned long) stats.collocate_pixels, (unsigned long) stats.collocate_matched, (unsigned long) job.visited);
+
+	int ok = 0;
+	hid_t h5id = H5Fcreate(out, H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+
+	if (h5id >= 0) {
+		ok = write_pixel_map(h5id, rows, cols, geo->cols, job.pixel, job.distance);
+
+		int i;
+		for (i = 0; i < variable_count; i++) {
+			if (!grid_variable(h5id, path, variables[i], rows, cols, geo, job.pixel)) {
+				fprintf(stderr, "Unable to collocate %s, 2-d integer or float variables only\n", variables[i]);
+				ok = 0;
+			}
+		}
+
+		H5Fclose(h5id);
+	}
+
+	free(job.pixel);
+	free(job.distance);
+	free_validity_mask(job.src_mask);
+	free_geolocation(src_lat);
+	free_geolocation(src_lon);
+
+	return ok;
+}
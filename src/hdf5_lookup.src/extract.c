@@ -0,0 +1,239 @@
+/*
+ *	Program: HDF5 Lookup v0.1
+ *
+ *	Usage: This code is free to use and modify, so long
+ *		as this header remains intact, except for
+ *		"Modifications" below.
+ *
+ *	Purpose: Read a variable at the located pixels of all targets.
+ *
+ *		The dataset is opened once and only the requested elements are
+ *		read. The read plan groups the elements by the chunk holding
+ *		them and issues one point selection read per chunk, in chunk
+ *		order, so each chunk is decompressed once whatever order the
+ *		targets came in. The chunk cache is sized from the planned
+ *		working set (chunks touched, up to CHUNK_CACHE_MAX_BYTES) and
+ *		never below one chunk, which the 1 MB default often is.
+ *
+ *		A virtual dataset (orbit.c) has no chunks, its mapping blocks
+ *		(one granule each) take their place, so each source file is
+ *		reached by one read.
+ *
+ *		Geolocation row/col are rescaled to the variable's own extent,
+ *		for variables at a different resolution than lat/lon. ll_rows 0
+ *		scales rows as the columns, for a file still growing (follow.c).
+ *
+ *		Elements that cannot be read (e.g. rows a file being written has
+ *		not reached in this variable yet) are NAN, or LOOKUP_UNREAD_INT
+ *		for integers, and their targets are marked unread.
+ *
+ *	Functions
+ *		int			scale_index			- geolocation index to variable index
+ *		int			virtual_block_rows	- rows of the first mapping of a virtual dataset, 0 if not virtual
+ *		H5T_class_t	extract_variable	- values of one variable for every located target
+ *
+ *	Modifications:
+ *		2026 10 18 - Initial Version
+ *		2026 10 18 - One read per chunk, sized chunk cache, -s statistics
+ *		2026 10 18 - Virtual datasets read per mapping block
+ *		2026 10 18 - ll_rows 0 for files still being written
+ */
+
+#include <limits.h>
+
+#define DEBUG_EXTRACT 0
+
+#define CHUNK_CACHE_MAX_BYTES (64 * 1024 * 1024)
+#define LOOKUP_UNREAD_INT LLONG_MIN		// integer value of an element that could not be read
+
+typedef union {
+	double f;					// H5T_FLOAT variables
+	long long i;				// H5T_INTEGER variables
+} lookup_value;
+
+int scale_index(int ll_index, int ll_count, int count) {
+	return (int) ((float) ll_index * ((float) count / (float) ll_count));
+}
+
+int virtual_block_rows(hid_t dcpl) {
+
+	size_t mappings = 0;
+	if (H5Pget_layout(dcpl) != H5D_VIRTUAL || H5Pget_virtual_count(dcpl, &mappings) < 0 || mappings == 0) return 0;
+
+	hsize_t start[MAX_DIMS], end[MAX_DIMS];
+	hid_t vspace = H5Pget_virtual_vspace(dcpl, 0);
+	herr_t status = H5Sget_select_bounds(vspace, start, end);
+	H5Sclose(vspace);
+
+	return status < 0 ? 0 : (int) (end[0] - start[0] + 1);
+}
+
+H5T_class_t extract_variable(const char* path, const char* table, lookup_target* targets, int count, int ll_rows, int ll_cols, lookup_value* values) {
+
+	char *group_dat, *name_dat;
+	split_table_path(table, &group_dat, &name_dat);
+
+	if (DEBUG_EXTRACT) printf("dat path:  %s\n", path);
+	if (DEBUG_EXTRACT) printf("dat group: %s\n", group_dat);
+	if (DEBUG_EXTRACT) printf("dat name:  %s\n", name_dat);
+
+	hid_t* ids     = (hid_t*) get_variable_ids_by_name(path, group_dat, name_dat);
+	hid_t h5id     = ids[0];
+	hid_t grp_h5id = ids[1];
+	hid_t varid    = ids[2];
+	free(ids);
+
+	H5T_class_t data_type = get_variable_type(varid);
+	hsize_t* dims = (hsize_t*) get_variable_dims(grp_h5id, varid);
+
+	hid_t mem_type = -1;
+	if (data_type == H5T_INTEGER) mem_type = H5T_NATIVE_LLONG;
+	if (data_type == H5T_FLOAT)   mem_type = H5T_NATIVE_DOUBLE;
+
+	if (DEBUG_EXTRACT) printf("data_type is: %d %d %d\n", data_type, H5T_INTEGER, H5T_FLOAT);
+	if (DEBUG_EXTRACT) printf(" %d %d %d\n", (int) dims[0], (int) dims[1], (int) dims[2]);
+
+	// Chunk extent, a contiguous dataset is one chunk
+	hsize_t chunk[MAX_DIMS] = { dims[0], dims[1], dims[2] };
+	hid_t dcpl = H5Dget_create_plist(varid);
+	int chunked = H5Pget_layout(dcpl) == H5D_CHUNKED;
+	if (chunked) H5Pget_chunk(dcpl, MAX_DIMS, chunk);
+	int block_rows = virtual_block_rows(dcpl);
+	if (block_rows > 0) chunk[0] = block_rows;
+	H5Pclose(dcpl);
+
+	hid_t dataset_space = H5Dget_space(varid);
+	int ndims = H5Sget_simple_extent_ndims(dataset_space);
+	H5Sclose(dataset_space);
+
+	size_t chunk_elements = 1;
+	int dim_i;
+	for (dim_i = 0; dim_i < ndims; dim_i++) chunk_elements *= chunk[dim_i];
+
+	// Plan keys are chunk_id * chunk_plane + position inside the chunk
+	unsigned long chunk_plane = chunk[0] * chunk[1];
+	int chunks_across = (dims[1] + chunk[1] - 1) / chunk[1];
+
+	int* located = malloc(sizeof(int) * count);
+	int* new_row = malloc(sizeof(int) * count);
+	int* new_col = malloc(sizeof(int) * count);
+	unsigned long* keys = malloc(sizeof(unsigned long) * count);
+	int located_count = 0;
+	int i;
+
+	for (i = 0; i < count; i++) {
+		if (!targets[i].found) continue;
+
+		int r = ll_rows > 0 ? scale_index(targets[i].row, ll_rows, dims[0]) : scale_index(targets[i].row, ll_cols, dims[1]);
+		int c = scale_index(targets[i].col, ll_cols, dims[1]);
+
+		unsigned long chunk_id = (r / chunk[0]) * chunks_across + (c / chunk[1]);
+
+		located[located_count] = i;
+		new_row[located_count] = r;
+		new_col[located_count] = c;
+		keys[located_count] = chunk_id * chunk_plane + (r % chunk[0]) * chunk[1] + (c % chunk[1]);
+		located_count++;
+	}
+
+	int* plan = plan_by_key(keys, located_count);
+
+	// Working set is every distinct chunk in the plan
+	int planned_chunks = 0;
+	for (i = 0; i < located_count; i++) {
+		if (i == 0 || keys[plan[i]] / chunk_plane != keys[plan[i - 1]] / chunk_plane) planned_chunks++;
+	}
+
+	if (chunked && mem_type >= 0 && located_count > 0) {
+		hid_t file_type = H5Dget_type(varid);
+		size_t chunk_bytes = chunk_elements * H5Tget_size(file_type);
+		H5Tclose(file_type);
+
+		size_t cache_bytes = planned_chunks * chunk_bytes;
+		if (cache_bytes > CHUNK_CACHE_MAX_BYTES) cache_bytes = CHUNK_CACHE_MAX_BYTES;
+		if (cache_bytes < chunk_bytes) cache_bytes = chunk_bytes;
+
+		H5Dclose(varid);
+		varid = open_variable_with_chunk_cache(grp_h5id, name_dat, cache_bytes, chunk_bytes);
+
+		if (cache_bytes > stats.chunk_cache_bytes) stats.chunk_cache_bytes = cache_bytes;
+	}
+
+	if (mem_type >= 0) {
+		hsize_t* coords = malloc(sizeof(hsize_t) * ndims * (located_count > 0 ? located_count : 1));
+		lookup_value* buffer = malloc(sizeof(lookup_value) * (located_count > 0 ? located_count : 1));
+		int* slot = malloc(sizeof(int) * (located_count > 0 ? located_count : 1));
+
+		// One point selection read per chunk, chunks in plan order
+		int first = 0;
+		while (first < located_count) {
+			unsigned long chunk_id = keys[plan[first]] / chunk_plane;
+
+			// Targets on the same element share one point, virtual datasets reject repeats
+			hsize_t n = 0;
+			int last = first;
+			while (last < located_count && keys[plan[last]] / chunk_plane == chunk_id) {
+				int k = plan[last];
+				if (last == first || keys[k] != keys[plan[last - 1]]) {
+					hsize_t* coord = &coords[n * ndims];
+					for (dim_i = 0; dim_i < ndims; dim_i++) coord[dim_i] = 0;
+					coord[0] = new_row[k];
+					if (ndims > 1) coord[1] = new_col[k];
+					n++;
+				}
+				slot[last - first] = n - 1;
+				last++;
+			}
+
+			if (DEBUG_EXTRACT) printf(" chunk %lu: %d elements\n", chunk_id, (int) n);
+
+			hid_t file_space = H5Dget_space(varid);
+			hid_t memory_space = H5Screate_simple(1, &n, NULL);
+
+			int read = H5Sselect_elements(file_space, H5S_SELECT_SET, n, coords) >= 0
+				&& H5Dread(varid, mem_type, memory_space, file_space, H5P_DEFAULT, buffer) >= 0;
+
+			H5Sclose(memory_space);
+			H5Sclose(file_space);
+
+			for (i = first; i < last; i++) {
+				int t_i = located[plan[i]];
+				if (read) {
+					values[t_i] = buffer[slot[i - first]];
+				} else if (data_type == H5T_FLOAT) {
+					values[t_i].f = NAN;
+					targets[t_i].unread = 1;
+				} else {
+					values[t_i].i = LOOKUP_UNREAD_INT;
+					targets[t_i].unread = 1;
+				}
+			}
+
+			stats.variable_reads++;
+			stats.variable_elements += n;
+
+			first = last;
+		}
+
+		if (chunked) stats.variable_chunks += planned_chunks;
+
+		free(coords);
+		free(buffer);
+		free(slot);
+	}
+
+	free(plan);
+	free(keys);
+	free(located);
+	free(new_row);
+	free(new_col);
+	free(dims);
+	free(group_dat);
+	free(name_dat);
+
+	H5Dclose(varid);
+	H5Gclose(grp_h5id);
+	H5Fclose(h5id);
+
+	return data_type;
+}
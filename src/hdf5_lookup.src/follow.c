@@ -0,0 +1,218 @@
+/*
+ *	Program: HDF5 Lookup v0.1
+ *
+ *	Usage: This code is free to use and modify, so long
+ *		as this header remains intact, except for
+ *		"Modifications" below.
+ *
+ *	Purpose: Follow mode (-F interval{:idle}) for a granule still being
+ *		written scan by scan with SWMR (single writer, multiple readers).
+ *		File is opened as a SWMR reader and polled every interval seconds:
+ *		LatTable/LonTable are refreshed (H5Drefresh, see hdf5_helper.c)
+ *		and only the rows appended since the last poll are read and
+ *		searched, for the -b targets still pending. Nothing older is
+ *		kept in memory, nor any dataset left open between polls.
+ *
+ *		A target is answered as soon as its match is settled, i.e. at
+ *		least FOLLOW_SETTLE_ROWS rows have been written after the matched
+ *		row (the swath moves away along the track, later rows are only
+ *		farther). Answers are printed as they settle, so output follows
+ *		the order of arrival rather than the targets file.
+ *
+ *		The variables are written apart from LatTable/LonTable and may
+ *		lag them: a value is only read once FOLLOW_SETTLE_ROWS rows have
+ *		been written after it as well, and one that cannot be read keeps
+ *		its target pending until the file is complete.
+ *
+ *		The file is taken as complete after idle seconds (default
+ *		FOLLOW_IDLE_POLLS polls) without new rows; matches still
+ *		pending are then final, targets without one are dropped.
+ *
+ *	Functions
+ *		int				parse_follow_spec		- interval and idle seconds of -F
+ *		swath_follower*	open_follower			- SWMR reader over LatTable/LonTable
+ *		int				follow_appended_rows	- search the new rows for the pending targets
+ *		int				settle_targets			- targets answered since the last call
+ *		int				follow_variable_rows	- rows of LatTable a variable has been written for
+ *		void			unsettle_target			- an answered target pending again, its variables not read yet
+ *		void			close_follower
+ *
+ *	Modifications:
+ *		2026 10 18 - Initial Version
+ */
+
+#define DEBUG_FOLLOW 0
+
+#define FOLLOW_SETTLE_ROWS 32
+#define FOLLOW_IDLE_POLLS 10
+
+typedef struct {
+	const char* path;
+	char* group_lat;
+	char* name_lat;
+	char* group_lon;
+	char* name_lon;
+	int rows;					// searched so far
+	int cols;
+	double max_km;
+	int* answered;				// per target
+} swath_follower;
+
+int parse_follow_spec(const char* spec, double* interval, double* idle) {
+
+	char* end;
+	*interval = strtod(spec, &end);
+	if (end == spec || *interval <= 0) return 0;
+
+	*idle = *interval * FOLLOW_IDLE_POLLS;
+	if (*end == ':') *idle = strtod(end + 1, &end);
+
+	return *end == 0 && *idle >= 0;
+}
+
+// Rows written to both tables, the writer may be between the two
+int follower_extent(swath_follower* f, int* cols) {
+
+	geo_table lat, lon;
+	if (!describe_geo_table(f->path, f->group_lat, f->name_lat, &lat) || !describe_geo_table(f->path, f->group_lon, f->name_lon, &lon)) return -1;
+	if (lat.cols != lon.cols) return -1;
+
+	*cols = lat.cols;
+	return lat.rows < lon.rows ? lat.rows : lon.rows;
+}
+
+void close_follower(swath_follower* f) {
+	if (f == NULL) return;
+	free(f->group_lat);
+	free(f->name_lat);
+	free(f->group_lon);
+	free(f->name_lon);
+	free(f->answered);
+	free(f);
+}
+
+swath_follower* open_follower(const char* path, const char* lat_table, const char* lon_table, int count, double max_km) {
+
+	swath_follower* f = calloc(1, sizeof(swath_follower));
+	f->path = path;
+	f->max_km = max_km;
+	f->answered = calloc(count > 0 ? count : 1, sizeof(int));
+
+	split_table_path(lat_table, &f->group_lat, &f->name_lat);
+	split_table_path(lon_table, &f->group_lon, &f->name_lon);
+
+	int cols;
+	if (follower_extent(f, &cols) < 0) {
+		close_follower(f);
+		return NULL;
+	}
+
+	return f;
+}
+
+int follow_appended_rows(swath_follower* f, lookup_target* targets, int count) {
+
+	stats.follow_polls++;
+
+	int cols;
+	int rows = follower_extent(f, &cols);
+	if (rows <= f->rows) return 0;
+
+	granule_band band;
+	memset(&band, 0, sizeof(granule_band));
+
+	hsize_t start[2] = { f->rows, 0 };
+	hsize_t extent[2] = { rows - f->rows, cols };
+
+	band.row0 = f->rows;
+	band.lat = load_geolocation_window(f->path, f->group_lat, f->name_lat, start, NULL, extent);
+	band.lon = load_geolocation_window(f->path, f->group_lon, f->name_lon, start, NULL, extent);
+
+	if (band.lat == NULL || band.lon == NULL) {
+		free_granule_band(&band);
+		return 0;
+	}
+
+	band.mask = build_validity_mask(band.lat, band.lon);
+	stats.geolocation_valid += band.mask->valid;
+
+	int i;
+	for (i = 0; i < count; i++) {
+		if (!f->answered[i]) search_granule_band(&band, &targets[i], NULL, 0);
+	}
+
+	if (DEBUG_FOLLOW) printf("follow %s: rows %d .. %d\n", f->path, f->rows, rows - 1);
+
+	free_granule_band(&band);
+
+	stats.follow_rows += rows - f->rows;
+	f->rows = rows;
+	f->cols = cols;
+
+	return extent[0];
+}
+
+// ready holds a copy of the targets, found only for those answered now
+int settle_targets(swath_follower* f, lookup_target* targets, int count, int final, lookup_target* ready) {
+
+	int i, settled = 0;
+	for (i = 0; i < count; i++) {
+		lookup_target* t = &targets[i];
+
+		ready[i] = *t;
+		ready[i].found = 0;
+		ready[i].unread = 0;
+
+		if (f->answered[i]) continue;
+
+		int matched = t->found && t->distance < f->max_km;
+		if (!final && !(matched && t->row < f->rows - FOLLOW_SETTLE_ROWS)) continue;
+
+		f->answered[i] = 1;
+		ready[i].found = matched;
+		settled++;
+
+		stats.targets++;
+		if (matched) stats.matches++;
+	}
+
+	return settled;
+}
+
+// Extent of a 2-d variable in LatTable rows, rows scale as the columns do (see extract.c), -1 otherwise
+int follow_variable_rows(swath_follower* f, const char* variable) {
+
+	char* group;
+	char* name;
+	split_table_path(variable, &group, &name);
+
+	hid_t* ids     = (hid_t*) get_variable_ids_by_name(f->path, group, name);
+	hid_t h5id     = ids[0];
+	hid_t grp_h5id = ids[1];
+	hid_t varid    = ids[2];
+	free(ids);
+	free(group);
+	free(name);
+
+	// Every handle is closed, an open one would keep a stale view of the growing file
+	hid_t dataset_space = H5Dget_space(varid);
+	hsize_t dims[MAX_DIMS] = { 0, 0 };
+	int rows = -1;
+	if (H5Sget_simple_extent_ndims(dataset_space) == 2 && H5Sget_simple_extent_dims(dataset_space, dims, NULL) >= 0 && dims[1] > 0) {
+		rows = (int) ((long long) dims[0] * f->cols / dims[1]);
+	}
+	H5Sclose(dataset_space);
+
+	H5Dclose(varid);
+	H5Gclose(grp_h5id);
+	H5Fclose(h5id);
+
+	return rows;
+}
+
+// Variables can lag the lat/lon rows, the target waits for the next poll
+void unsettle_target(swath_follower* f, lookup_target* t, int i) {
+	f->answered[i] = 0;
+	stats.targets--;
+	if (t->found) stats.matches--;
+}
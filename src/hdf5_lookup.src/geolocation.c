@@ -0,0 +1,194 @@
+/*
+ *	Program: HDF5 Lookup v0.1
+ *
+ *	Usage: This code is free to use and modify, so long
+ *		as this header remains intact, except for
+ *		"Modifications" below.
+ *
+ *	Purpose: One entry point for the geolocation search modes, so a
+ *		target is located the same way for one or many targets.
+ *
+ *		brute force		full lat/lon tables held in data_lat/data_lon
+ *		raster			raster set (-r), refined over data_lat/data_lon,
+ *						approximate with tolerance_km set (-e)
+ *		space/time		row_penalty set (-t) for the brute force or raster search
+ *		tie-point		tp set (-T), data_lat/data_lon are the tie grids
+ *		pyramid			ps set (-p), lat/lon read piecewise from the file
+ *
+ *	Functions
+ *		geo_table*	load_geolocation	- lat or lon table in its stored type (geotable.c)
+ *		geo_table*	load_geolocation_window	- rows/cols of a lat or lon table, strided, as their own table
+ *		void		set_geolocation_packing	- whole tables are packed once loaded (packed.c)
+ *		void		free_geolocation	- release a table from load_geolocation
+ *		int			locate_pixel		- row/col and observed lat/lon nearest a target
+ *
+ *	Modifications:
+ *		2026 10 18 - Initial Version
+ *		2026 10 18 - Parallel direct chunk loading (-j)
+ *		2026 10 18 - Contiguous native tables are mapped, not read
+ *		2026 10 18 - Tables kept in their stored type (float, double, scaled int)
+ *		2026 10 18 - Brute force and tie-point searches use the validity mask
+ *		2026 10 18 - Inverse lookup raster search
+ *		2026 10 18 - Space/time ranking through row penalties
+ *		2026 10 18 - Partial tables (load_geolocation_window) for virtual swaths
+ *		2026 10 18 - Packed whole tables (-z)
+ *		2026 10 18 - Raster search within a tolerance (-e)
+ */
+
+typedef struct {
+	const char* path;
+	const char* group_lat;
+	const char* name_lat;
+	const char* group_lon;
+	const char* name_lon;
+	int rows;					// geolocation resolution (full resolution for tie-points)
+	int cols;
+	geo_table* data_lat;
+	geo_table* data_lon;
+	validity_mask* mask;		// whole tables only
+	inverse_raster* raster;
+	double tolerance_km;		// approximate raster search, -e (approx.c)
+	const double* row_penalty;	// per target, -t (scantime.c)
+	tiepoint_grid* tp;
+	pyramid_search* ps;
+	int pyramid_stride;
+} geolocation;
+
+int geolocation_packing = 0;
+
+void set_geolocation_packing(int packing) {
+	geolocation_packing = packing;
+}
+
+// Replaces the loaded data with its packed form, decoded and within PACKED_QUANTUM / 2
+void pack_geolocation(geo_table* t) {
+
+	packed_table* pt = new_packed_table(t->rows, t->cols);
+	double* values = malloc(sizeof(double) * t->cols);
+
+	int row, col;
+	for (row = 0; row < t->rows; row++) {
+		for (col = 0; col < t->cols; col++) {
+			double value = geo_value(t, row, col);
+			values[col] = value == GEO_FILL ? NAN : value;
+		}
+		pack_row(pt, row, values);
+	}
+
+	stats.geolocation_unpacked_bytes += (size_t) t->rows * t->cols * H5Tget_size(t->mem_type);
+	stats.geolocation_packed_bytes += packed_table_bytes(pt);
+
+	free(values);
+	free_variable_data(t->data);
+
+	t->data = pt;
+	t->storage = GEO_PACKED;
+	t->scale = 1.;
+	t->offset = 0.;
+	t->has_fill = 0;
+}
+
+// Contiguous unfiltered tables are mapped from the file. With threads,
+// chunks are decompressed in parallel when the filters allow it.
+// Without load_data only the storage and scaling are filled in.
+// With set_geolocation_packing the table is then packed.
+geo_table* load_geolocation(const char* path, const char* group, const char* name, int threads, int load_data) {
+
+	geo_table* t = malloc(sizeof(geo_table));
+
+	if (!describe_geo_table(path, group, name, t)) {
+		free(t);
+		return NULL;
+	}
+
+	if (!load_data) return t;
+
+	t->data = get_variable_data_by_name_mmap(path, group, name, t->mem_type);
+	if (t->data != NULL) stats.geolocation_mapped++;
+
+	if (t->data == NULL && threads > 0) {
+		t->data = get_variable_data_by_name_direct(path, group, name, t->mem_type, threads);
+		if (t->data != NULL) stats.geolocation_direct++;
+	}
+
+	if (t->data == NULL) {
+		hsize_t start[2] = { 0, 0 };
+		hsize_t count[2] = { t->rows, t->cols };
+		t->data = get_variable_hyperslab_by_name_dimalloc2(path, group, name, t->mem_type, start, NULL, count);
+	}
+
+	if (t->data == NULL) {
+		free(t);
+		return NULL;
+	}
+
+	if (geolocation_packing) pack_geolocation(t);
+
+	return t;
+}
+
+// count rows/cols from start, every stride (NULL for 1), e.g. a boundary band or a coarse footprint
+geo_table* load_geolocation_window(const char* path, const char* group, const char* name, const hsize_t* start, const hsize_t* stride, const hsize_t* count) {
+
+	geo_table* t = malloc(sizeof(geo_table));
+
+	if (!describe_geo_table(path, group, name, t) || count[0] == 0 || count[1] == 0) {
+		free(t);
+		return NULL;
+	}
+
+	t->data = get_variable_hyperslab_by_name_dimalloc2(path, group, name, t->mem_type, start, stride, count);
+	if (t->data == NULL) {
+		free(t);
+		return NULL;
+	}
+
+	t->rows = count[0];
+	t->cols = count[1];
+
+	stats.geolocation_elements += count[0] * count[1];
+
+	return t;
+}
+
+void free_geolocation(geo_table* t) {
+	if (t == NULL) return;
+	if (t->storage == GEO_PACKED) free_packed_table((packed_table*) t->data);
+	else free_variable_data(t->data);
+	free(t);
+}
+
+// Returns 1 and fills row/col/obs_lat/obs_lon if a valid pixel was found
+int locate_pixel(geolocation* geo, float target_lat, float target_lon, int* row, int* col, double* obs_lat, double* obs_lon) {
+
+	int* indices;
+
+	if (geo->tp != NULL) {
+		indices = (int*) get_indices_from_tiepoints(geo->tp, target_lat, target_lon);
+	} else if (geo->ps != NULL) {
+		indices = (int*) get_indices_from_pyramid(geo->ps, geo->pyramid_stride, target_lat, target_lon);
+	} else if (geo->raster != NULL) {
+		indices = (int*) get_indices_from_raster(geo->raster, geo->data_lat, geo->data_lon, geo->row_penalty, geo->tolerance_km, target_lat, target_lon);
+	} else if (geo->row_penalty != NULL) {
+		indices = (int*) get_indices_from_geo_timed(geo->data_lat, geo->data_lon, geo->mask, geo->row_penalty, target_lat, target_lon);
+	} else {
+		indices = (int*) get_indices_from_geo_tables(geo->data_lat, geo->data_lon, geo->mask, target_lat, target_lon);
+	}
+
+	*row = indices[0];
+	*col = indices[1];
+	free(indices);
+
+	if (!((*row >= 0 && *row < geo->rows) && (*col >= 0 && *col < geo->cols))) return 0;
+
+	if (geo->tp != NULL) {
+		tiepoint_interpolate(geo->tp, *row, *col, obs_lat, obs_lon);
+	} else if (geo->ps != NULL) {
+		pyramid_value(geo->ps, *row, *col, obs_lat, obs_lon);
+	} else {
+		*obs_lat = geo_value(geo->data_lat, *row, *col);
+		*obs_lon = geo_value(geo->data_lon, *row, *col);
+	}
+
+	return 1;
+}
@@ -0,0 +1,181 @@
+/*
+ *	Program: HDF5 Lookup v0.1
+ *
+ *	Usage: This code is free to use and modify, so long
+ *		as this header remains intact, except for
+ *		"Modifications" below.
+ *
+ *	Purpose: Latitude/Longitude tables kept in the type they are stored
+ *		in, read with the matching native memory type and never widened
+ *		into a temporary array.
+ *
+ *		GEO_FLOAT32		float
+ *		GEO_FLOAT64		double
+ *		GEO_INT16		short, scaled (scale_factor, add_offset)
+ *		GEO_UINT16		unsigned short, scaled
+ *		GEO_INT32		int, scaled (any other integer is read as int)
+ *		GEO_PACKED		quantized blocks (packed.c, -z), values decoded
+ *
+ *		Pixels equal to the _FillValue attribute decode to GEO_FILL, floats
+ *		also keep the (lat > -9999) test of the original search. The brute
+ *		force search kernels for each storage type are in nearest.c.
+ *		Packed tables are only made from loaded ones (geolocation.c), and
+ *		keep missing values as NAN.
+ *
+ *	Functions
+ *		int			describe_geo_table			- storage, memory type, extent and scaling of a table
+ *		double		geo_value					- one decoded value, GEO_FILL if missing
+ *
+ *	Modifications:
+ *		2026 10 18 - Initial Version
+ *		2026 10 18 - Kernels moved to nearest.c, _FillValue applies to floats
+ *		2026 10 18 - Packed storage (packed.c)
+ */
+
+#define DEBUG_GEOTABLE 0
+
+#define GEO_FILL -99999.
+
+typedef enum {
+	GEO_FLOAT32,
+	GEO_FLOAT64,
+	GEO_INT16,
+	GEO_UINT16,
+	GEO_INT32,
+	GEO_PACKED
+} geo_storage;
+
+typedef struct {
+	void* data;					// (type**) as stored, packed_table* when packed, NULL when read piecewise
+	geo_storage storage;
+	hid_t mem_type;
+	int rows;
+	int cols;
+	double scale;				// integer storage: value = raw * scale + offset
+	double offset;
+	int has_fill;				// _FillValue attribute, raw
+	double fill;
+} geo_table;
+
+double read_scalar_attribute(hid_t varid, const char* name, double default_value) {
+
+	double value = default_value;
+
+	if (H5Aexists(varid, name) > 0) {
+		hid_t attr = H5Aopen(varid, name, H5P_DEFAULT);
+		hid_t attr_space = H5Aget_space(attr);
+		if (H5Sget_simple_extent_npoints(attr_space) >= 1) {
+			// first element of arrays, e.g. VIIRS factor pairs
+			double* values = malloc(sizeof(double) * H5Sget_simple_extent_npoints(attr_space));
+			if (H5Aread(attr, H5T_NATIVE_DOUBLE, values) >= 0) value = values[0];
+			free(values);
+		}
+		H5Sclose(attr_space);
+		H5Aclose(attr);
+	}
+
+	return value;
+}
+
+int describe_geo_table(const char* path, const char* group, const char* name, geo_table* t) {
+
+	memset(t, 0, sizeof(geo_table));
+
+	hid_t* ids     = (hid_t*) get_variable_ids_by_name(path, group, name);
+	hid_t h5id     = ids[0];
+	hid_t grp_h5id = ids[1];
+	hid_t varid    = ids[2];
+	free(ids);
+
+	int ok = 1;
+
+	hid_t dataset_space = H5Dget_space(varid);
+	hsize_t dims[2] = { 0, 0 };
+	if (H5Sget_simple_extent_ndims(dataset_space) != 2) ok = 0;
+	if (ok) H5Sget_simple_extent_dims(dataset_space, dims, NULL);
+	H5Sclose(dataset_space);
+
+	t->rows = dims[0];
+	t->cols = dims[1];
+
+	hid_t file_type = H5Dget_type(varid);
+	H5T_class_t type_class = H5Tget_class(file_type);
+	size_t type_size = H5Tget_size(file_type);
+	H5T_sign_t type_sign = H5Tget_sign(file_type);
+	H5Tclose(file_type);
+
+	t->scale = 1.;
+	t->offset = 0.;
+
+	if (type_class == H5T_FLOAT && type_size > 4) {
+		t->storage = GEO_FLOAT64;
+		t->mem_type = H5T_NATIVE_DOUBLE;
+	} else if (type_class == H5T_FLOAT) {
+		t->storage = GEO_FLOAT32;
+		t->mem_type = H5T_NATIVE_FLOAT;
+	} else if (type_class == H5T_INTEGER && type_size <= 2 && type_sign == H5T_SGN_NONE) {
+		t->storage = GEO_UINT16;
+		t->mem_type = H5T_NATIVE_USHORT;
+	} else if (type_class == H5T_INTEGER && type_size <= 2) {
+		t->storage = GEO_INT16;
+		t->mem_type = H5T_NATIVE_SHORT;
+	} else if (type_class == H5T_INTEGER) {
+		t->storage = GEO_INT32;
+		t->mem_type = H5T_NATIVE_INT;
+	} else {
+		ok = 0;
+	}
+
+	if (ok && type_class == H5T_INTEGER) {
+		t->scale = read_scalar_attribute(varid, "scale_factor", 1.);
+		t->offset = read_scalar_attribute(varid, "add_offset", 0.);
+	}
+
+	if (ok && H5Aexists(varid, "_FillValue") > 0) {
+		t->has_fill = 1;
+		t->fill = read_scalar_attribute(varid, "_FillValue", 0.);
+	}
+
+	if (DEBUG_GEOTABLE) printf("geo table %s: %d x %d, storage %d, scale %g, offset %g, fill %d %g\n",
+		name, t->rows, t->cols, t->storage, t->scale, t->offset, t->has_fill, t->fill);
+
+	H5Dclose(varid);
+	H5Gclose(grp_h5id);
+	H5Fclose(h5id);
+
+	return ok;
+}
+
+double geo_value(geo_table* t, int row, int col) {
+
+	double raw;
+
+	if (t->storage == GEO_PACKED) {
+		raw = packed_value((packed_table*) t->data, row, col);
+		return isnan(raw) ? GEO_FILL : raw;
+	}
+
+	switch (t->storage) {
+		case GEO_FLOAT32:
+			raw = ((float**) t->data)[row][col];
+			break;
+		case GEO_FLOAT64:
+			raw = ((double**) t->data)[row][col];
+			break;
+		case GEO_INT16:
+			raw = ((short**) t->data)[row][col];
+			break;
+		case GEO_UINT16:
+			raw = ((unsigned short**) t->data)[row][col];
+			break;
+		default:
+			raw = ((int**) t->data)[row][col];
+			break;
+	}
+
+	if (t->has_fill && raw == t->fill) return GEO_FILL;
+
+	if (t->storage == GEO_FLOAT32 || t->storage == GEO_FLOAT64) return raw > -9999 ? raw : GEO_FILL;
+
+	return raw * t->scale + t->offset;
+}
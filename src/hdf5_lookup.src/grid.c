@@ -0,0 +1,391 @@
+/*
+ *	Program: HDF5 Lookup v0.1
+ *
+ *	Usage: This code is free to use and modify, so long
+ *		as this header remains intact, except for
+ *		"Modifications" below.
+ *
+ *	Purpose: Swath to grid resampling (-g south,north,west,east,deg -o Out.h5).
+ *		Every cell of a regular lat/lon grid takes the value of the
+ *		nearest valid swath pixel within MAX_GOOD_DIS_KM of its center,
+ *		found through the inverse raster (raster.c), and is left at the
+ *		variable's fill value when there is none.
+ *
+ *		Cell centers run north to south by row and west to east by
+ *		column: row i is at north - (i + 0.5) * deg, column j at
+ *		west + (j + 0.5) * deg. The grid may cross the dateline
+ *		(east > 180), longitudes past 180 are taken as east of it.
+ *
+ *		Cells are matched in GRID_TILE x GRID_TILE tiles handed out to
+ *		the -j threads, each tile a compact patch of neighbouring cells
+ *		so a thread's raster lookups stay in the same few raster cells,
+ *		and each lookup is warm started from the match of the cell before.
+ *		Variables are then read whole, once each, and gathered through
+ *		the cell to pixel map on the main thread (HDF5 is not thread safe).
+ *
+ *	Output (Out.h5, overwritten):
+ *		latitude, longitude		cell centers, 1-d
+ *		pixel_row, pixel_col	swath pixel of each cell, -1 if none
+ *		distance				km from the cell center to its pixel
+ *		Name					each variable, in its own native type, with its
+ *								_FillValue, scale_factor and add_offset
+ *
+ *	Functions
+ *		int			parse_grid_spec		- grid of south,north,west,east,deg
+ *		hid_t		create_grid_dataset	- rows x cols output dataset
+ *		int			write_pixel_map		- pixel_row, pixel_col and distance of a match
+ *		int			grid_variable		- one variable gathered through a match
+ *		int			grid_swath			- match the cells and write the output file
+ *
+ *	Modifications:
+ *		2026 10 18 - Initial Version
+ *		2026 10 18 - Output helpers take any rows x cols, for collocation
+ */
+
+#define DEBUG_GRID 0
+
+#define GRID_TILE 64
+#define GRID_RASTER_DEG 0.05		// -r default in grid mode
+#define MAX_GRID_CELLS (256 * 1024 * 1024)
+
+typedef struct {
+	double south;
+	double north;
+	double west;
+	double east;
+	double cell;				// degrees
+	int nlat;
+	int nlon;
+} grid_spec;
+
+typedef struct {
+	grid_spec* g;
+	geolocation* geo;
+	int* pixel;					// per cell, row * cols + col or -1
+	float* distance;
+	int tiles_across;
+	int tiles;
+	int next_tile;				// shared, under lock
+	pthread_mutex_t lock;
+	size_t visited;				// summed from the workers, under lock
+} grid_job;
+
+int parse_grid_spec(const char* spec, grid_spec* g) {
+
+	memset(g, 0, sizeof(grid_spec));
+
+	if (sscanf(spec, "%lf,%lf,%lf,%lf,%lf", &g->south, &g->north, &g->west, &g->east, &g->cell) != 5) return 0;
+	if (g->cell <= 0 || g->south >= g->north || g->west >= g->east) return 0;
+	if (g->south < -90 || g->north > 90 || g->east - g->west > 360) return 0;
+
+	// A last partial cell is kept, tiny remainders from rounding are not
+	double nlat = ceil((g->north - g->south) / g->cell - 1e-9);
+	double nlon = ceil((g->east - g->west) / g->cell - 1e-9);
+	if (nlat * nlon > MAX_GRID_CELLS) return 0;
+
+	g->nlat = nlat;
+	g->nlon = nlon;
+
+	return 1;
+}
+
+void* grid_worker(void* arg) {
+
+	grid_job* job = (grid_job*) arg;
+	grid_spec* g = job->g;
+	geolocation* geo = job->geo;
+	size_t visited = 0;
+
+	while (1) {
+		pthread_mutex_lock(&job->lock);
+		int tile = job->next_tile++;
+		pthread_mutex_unlock(&job->lock);
+
+		if (tile >= job->tiles) break;
+
+		int i0 = (tile / job->tiles_across) * GRID_TILE;
+		int j0 = (tile % job->tiles_across) * GRID_TILE;
+		int i1 = i0 + GRID_TILE < g->nlat ? i0 + GRID_TILE : g->nlat;
+		int j1 = j0 + GRID_TILE < g->nlon ? j0 + GRID_TILE : g->nlon;
+
+		int i, j;
+		for (i = i0; i < i1; i++) {
+			double lat = g->north - (i + 0.5) * g->cell;
+
+			for (j = j0; j < j1; j++) {
+				double lon = g->west + (j + 0.5) * g->cell;
+				if (lon >= 180.) lon -= 360.;
+
+				double closest;
+				size_t cell = (size_t) i * g->nlon + j;
+
+				int hint = j > j0 ? job->pixel[cell - 1] : -1;
+
+				job->pixel[cell] = raster_nearest(geo->raster, geo->data_lat, geo->data_lon, lat, lon, hint, NULL, &closest, &visited);
+				job->distance[cell] = job->pixel[cell] >= 0 ? closest : -999.;
+			}
+		}
+	}
+
+	pthread_mutex_lock(&job->lock);
+	job->visited += visited;
+	pthread_mutex_unlock(&job->lock);
+
+	return NULL;
+}
+
+// Chunked, deflated 2-d dataset of type, with fill as _FillValue when given
+hid_t create_grid_dataset(hid_t h5id, const char* name, int rows, int cols, hid_t type, const void* fill) {
+
+	hsize_t dims[2] = { rows, cols };
+	hsize_t chunk[2] = { rows < GRID_TILE ? rows : GRID_TILE, cols < GRID_TILE ? cols : GRID_TILE };
+
+	hid_t space = H5Screate_simple(2, dims, NULL);
+	hid_t dcpl = H5Pcreate(H5P_DATASET_CREATE);
+	H5Pset_chunk(dcpl, 2, chunk);
+	H5Pset_deflate(dcpl, 4);
+	if (fill != NULL) H5Pset_fill_value(dcpl, type, fill);
+
+	hid_t varid = H5Dcreate(h5id, name, type, space, H5P_DEFAULT, dcpl, H5P_DEFAULT);
+
+	if (varid >= 0 && fill != NULL) {
+		hid_t attr_space = H5Screate(H5S_SCALAR);
+		hid_t attr = H5Acreate(varid, "_FillValue", type, attr_space, H5P_DEFAULT, H5P_DEFAULT);
+		H5Awrite(attr, type, fill);
+		H5Aclose(attr);
+		H5Sclose(attr_space);
+	}
+
+	H5Pclose(dcpl);
+	H5Sclose(space);
+
+	return varid;
+}
+
+void write_grid_attribute(hid_t varid, const char* name, double value) {
+	hid_t attr_space = H5Screate(H5S_SCALAR);
+	hid_t attr = H5Acreate(varid, name, H5T_NATIVE_DOUBLE, attr_space, H5P_DEFAULT, H5P_DEFAULT);
+	H5Awrite(attr, H5T_NATIVE_DOUBLE, &value);
+	H5Aclose(attr);
+	H5Sclose(attr_space);
+}
+
+void write_grid_axis(hid_t h5id, const char* name, double first, double step, int count) {
+
+	double* values = malloc(sizeof(double) * count);
+	int i;
+	for (i = 0; i < count; i++) values[i] = first + (i + 0.5) * step;
+
+	hsize_t dims[1] = { count };
+	hid_t space = H5Screate_simple(1, dims, NULL);
+	hid_t varid = H5Dcreate(h5id, name, H5T_NATIVE_DOUBLE, space, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+	H5Dwrite(varid, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT, values);
+	H5Dclose(varid);
+	H5Sclose(space);
+
+	free(values);
+}
+
+// pixel_row, pixel_col (-1 where nothing matched) and distance of a rows x cols match
+int write_pixel_map(hid_t h5id, int rows, int cols, int geo_cols, int* pixel, float* distance) {
+
+	size_t cells = (size_t) rows * cols, cell;
+	int ok = 1;
+
+	int* pixel_row = malloc(sizeof(int) * cells);
+	int* pixel_col = malloc(sizeof(int) * cells);
+	for (cell = 0; cell < cells; cell++) {
+		pixel_row[cell] = pixel[cell] >= 0 ? pixel[cell] / geo_cols : -1;
+		pixel_col[cell] = pixel[cell] >= 0 ? pixel[cell] % geo_cols : -1;
+	}
+
+	int fill_index = -1;
+	float fill_distance = -999.;
+	hid_t varid;
+
+	varid = create_grid_dataset(h5id, "pixel_row", rows, cols, H5T_NATIVE_INT, &fill_index);
+	if (varid < 0 || H5Dwrite(varid, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, pixel_row) < 0) ok = 0;
+	if (varid >= 0) H5Dclose(varid);
+
+	varid = create_grid_dataset(h5id, "pixel_col", rows, cols, H5T_NATIVE_INT, &fill_index);
+	if (varid < 0 || H5Dwrite(varid, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, pixel_col) < 0) ok = 0;
+	if (varid >= 0) H5Dclose(varid);
+
+	varid = create_grid_dataset(h5id, "distance", rows, cols, H5T_NATIVE_FLOAT, &fill_distance);
+	if (varid < 0 || H5Dwrite(varid, H5T_NATIVE_FLOAT, H5S_ALL, H5S_ALL, H5P_DEFAULT, distance) < 0) ok = 0;
+	if (varid >= 0) H5Dclose(varid);
+
+	free(pixel_row);
+	free(pixel_col);
+
+	return ok;
+}
+
+// Gather one 2-d variable through the rows x cols map of pixels into the output file
+int grid_variable(hid_t out_h5id, const char* path, const char* table, int rows, int cols, geolocation* geo, int* pixel) {
+
+	char *group_dat, *name_dat;
+	split_table_path(table, &group_dat, &name_dat);
+
+	int ok = 0;
+
+	if (H5Lexists(out_h5id, name_dat, H5P_DEFAULT) > 0) {
+		fprintf(stderr, "%s is already gridded, skipped\n", table);
+		free(group_dat);
+		free(name_dat);
+		return 1;
+	}
+
+	hid_t* ids     = (hid_t*) get_variable_ids_by_name(path, group_dat, name_dat);
+	hid_t h5id     = ids[0];
+	hid_t grp_h5id = ids[1];
+	hid_t varid    = ids[2];
+	free(ids);
+
+	hid_t dataset_space = H5Dget_space(varid);
+	int ndims = H5Sget_simple_extent_ndims(dataset_space);
+	hsize_t dims[2] = { 0, 0 };
+	if (ndims == 2) H5Sget_simple_extent_dims(dataset_space, dims, NULL);
+	H5Sclose(dataset_space);
+
+	hid_t file_type = H5Dget_type(varid);
+	hid_t mem_type = H5Tget_native_type(file_type, H5T_DIR_ASCEND);
+	H5T_class_t type_class = H5Tget_class(file_type);
+	H5Tclose(file_type);
+
+	if (ndims == 2 && (type_class == H5T_INTEGER || type_class == H5T_FLOAT)) {
+
+		size_t size = H5Tget_size(mem_type);
+
+		// _FillValue when the variable has one, else the dataset's fill
+		unsigned char fill[16];
+		memset(fill, 0, sizeof(fill));
+		if (H5Aexists(varid, "_FillValue") > 0) {
+			hid_t attr = H5Aopen(varid, "_FillValue", H5P_DEFAULT);
+			hid_t attr_space = H5Aget_space(attr);
+			if (H5Sget_simple_extent_npoints(attr_space) == 1) H5Aread(attr, mem_type, fill);
+			H5Sclose(attr_space);
+			H5Aclose(attr);
+		} else {
+			hid_t dcpl = H5Dget_create_plist(varid);
+			H5Pget_fill_value(dcpl, mem_type, fill);
+			H5Pclose(dcpl);
+		}
+
+		double scale = read_scalar_attribute(varid, "scale_factor", 1.);
+		double offset = read_scalar_attribute(varid, "add_offset", 0.);
+		int scaled = H5Aexists(varid, "scale_factor") > 0 || H5Aexists(varid, "add_offset") > 0;
+
+		hsize_t start[2] = { 0, 0 };
+		unsigned char* data = malloc(size * dims[0] * dims[1]);
+
+		if (read_variable_hyperslab(varid, mem_type, start, NULL, dims, data) >= 0) {
+
+			stats.variable_reads++;
+			stats.variable_elements += dims[0] * dims[1];
+
+			size_t cells = (size_t) rows * cols, cell;
+			unsigned char* gridded = malloc(size * cells);
+
+			for (cell = 0; cell < cells; cell++) {
+				if (pixel[cell] < 0) {
+					memcpy(&gridded[cell * size], fill, size);
+					continue;
+				}
+
+				// Geolocation row/col to the variable's own resolution
+				int r = scale_index(pixel[cell] / geo->cols, geo->rows, dims[0]);
+				int c = scale_index(pixel[cell] % geo->cols, geo->cols, dims[1]);
+				memcpy(&gridded[cell * size], &data[((size_t) r * dims[1] + c) * size], size);
+			}
+
+			hid_t out_varid = create_grid_dataset(out_h5id, name_dat, rows, cols, mem_type, fill);
+			if (out_varid >= 0) {
+				if (scaled) write_grid_attribute(out_varid, "scale_factor", scale);
+				if (scaled) write_grid_attribute(out_varid, "add_offset", offset);
+				ok = H5Dwrite(out_varid, mem_type, H5S_ALL, H5S_ALL, H5P_DEFAULT, gridded) >= 0;
+				H5Dclose(out_varid);
+			}
+
+			free(gridded);
+		}
+
+		free(data);
+	}
+
+	if (DEBUG_GRID) printf("grid %s: %d dims, %d x %d, ok %d\n", table, ndims, (int) dims[0], (int) dims[1], ok);
+
+	H5Tclose(mem_type);
+	H5Dclose(varid);
+	H5Gclose(grp_h5id);
+	H5Fclose(h5id);
+
+	free(group_dat);
+	free(name_dat);
+
+	return ok;
+}
+
+int grid_swath(const char* out, grid_spec* g, geolocation* geo, const char* path, char** variables, int variable_count, int threads) {
+
+	size_t cells = (size_t) g->nlat * g->nlon;
+
+	grid_job job;
+	memset(&job, 0, sizeof(grid_job));
+	job.g = g;
+	job.geo = geo;
+	job.pixel = malloc(sizeof(int) * cells);
+	job.distance = malloc(sizeof(float) * cells);
+	job.tiles_across = (g->nlon + GRID_TILE - 1) / GRID_TILE;
+	job.tiles = job.tiles_across * ((g->nlat + GRID_TILE - 1) / GRID_TILE);
+	pthread_mutex_init(&job.lock, NULL);
+
+	if (threads < 1) threads = 1;
+	if (threads > job.tiles) threads = job.tiles;
+
+	pthread_t* workers = malloc(sizeof(pthread_t) * threads);
+	int t;
+	for (t = 0; t < threads; t++) pthread_create(&workers[t], NULL, grid_worker, &job);
+	for (t = 0; t < threads; t++) pthread_join(workers[t], NULL);
+	free(workers);
+
+	pthread_mutex_destroy(&job.lock);
+
+	geo->raster->visited += job.visited;
+
+	size_t cell;
+	for (cell = 0; cell < cells; cell++) {
+		if (job.pixel[cell] >= 0) stats.grid_filled++;
+	}
+	stats.grid_cells = cells;
+
+	if (DEBUG_GRID) printf("grid %d x %d cells of %g deg, %d tiles on %d threads, %lu filled\n",
+		g->nlat, g->nlon, g->cell, job.tiles, threads, (unsigned long) stats.grid_filled);
+
+	int ok = 0;
+	hid_t h5id = H5Fcreate(out, H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+
+	if (h5id >= 0) {
+		ok = 1;
+
+		write_grid_axis(h5id, "latitude", g->north, -g->cell, g->nlat);
+		write_grid_axis(h5id, "longitude", g->west, g->cell, g->nlon);
+
+		if (!write_pixel_map(h5id, g->nlat, g->nlon, geo->cols, job.pixel, job.distance)) ok = 0;
+
+		int i;
+		for (i = 0; i < variable_count; i++) {
+			if (!grid_variable(h5id, path, variables[i], g->nlat, g->nlon, geo, job.pixel)) {
+				fprintf(stderr, "Unable to grid %s, 2-d integer or float variables only\n", variables[i]);
+				ok = 0;
+			}
+		}
+
+		H5Fclose(h5id);
+	}
+
+	free(job.pixel);
+	free(job.distance);
+
+	return ok;
+}
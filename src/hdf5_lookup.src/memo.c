@@ -0,0 +1,278 @@
+/*
+ *	Program: HDF5 Lookup v0.1
+ *
+ *	Usage: This code is free to use and modify, so long
+ *		as this header remains intact, except for
+ *		"Modifications" below.
+ *
+ *	Purpose: Result cache (-M Cache{:MB}), the output line of every
+ *		target kept in a memory mapped file shared by later runs, so the
+ *		same site in the same granule is answered without searching
+ *		again. When every target is cached the granule is never opened.
+ *
+ *		A line is keyed by the query, a hash of File's identity (path,
+ *		size and modification time, so a rewritten granule misses), the
+ *		tables and the options that change the result, and by the
+ *		target (lat, lon and time). Targets without a match are cached
+ *		too, as an empty line. Lines longer than MEMO_LINE_LEN are not.
+ *
+ *		The file holds MB (default MEMO_DEFAULT_MB) of MEMO_WAYS way
+ *		sets, a target maps to one set and evicts its least recently
+ *		used line. Runs take turns on the file (flock). A file of another
+ *		size or layout is never resized, since other runs may have it
+ *		mapped: an empty cache is written under a temporary name and
+ *		renamed over it, and runs still mapping the old file keep it.
+ *
+ *	Functions
+ *		memo_cache*	open_memo_cache		- map Cache{:MB}, NULL when it can not be used
+ *		uint64_t	memo_hash			- FNV-1a of bytes, continuing from h
+ *		int			memo_query_key		- key of File's identity, the tables and the options
+ *		char**		memo_lookup			- cached line per target, NULL when missing
+ *		void		memo_store			- line of one target, "" when it has no match
+ *		void		close_memo_cache
+ *
+ *	Modifications:
+ *		2026 10 18 - Initial Version
+ */
+
+#include <sys/mman.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+
+#define DEBUG_MEMO 0
+
+#define MEMO_DEFAULT_MB 64
+#define MEMO_WAYS 8
+#define MEMO_LINE_LEN 480
+#define MEMO_MAGIC 0x314f4d454d354648ULL	// "HF5MEMO1"
+#define MEMO_FNV_BASIS 0xcbf29ce484222325ULL
+#define MEMO_FNV_PRIME 0x100000001b3ULL
+
+typedef struct {
+	uint64_t magic;
+	uint64_t slots;
+	uint64_t clock;				// last use
+	uint64_t reserved[5];
+} memo_header;
+
+typedef struct {
+	uint64_t query;
+	uint64_t target;
+	uint64_t used;				// clock at last use, 0 when empty
+	int32_t length;
+	int32_t reserved;
+	char line[MEMO_LINE_LEN];
+} memo_slot;
+
+typedef struct {
+	int fd;
+	size_t bytes;
+	memo_header* header;
+	memo_slot* slots;
+	uint64_t sets;
+	uint64_t query;
+} memo_cache;
+
+uint64_t memo_hash(uint64_t h, const void* data, size_t length) {
+	const unsigned char* bytes = (const unsigned char*) data;
+	size_t i;
+	for (i = 0; i < length; i++) {
+		h ^= bytes[i];
+		h *= MEMO_FNV_PRIME;
+	}
+	return h;
+}
+
+// Returns 0 when File can not be found
+int memo_query_key(const char* path, char** tables, int table_count, const char* options, uint64_t* key) {
+
+	struct stat st;
+	char* real = realpath(path, NULL);
+	if (real == NULL || stat(real, &st) != 0) {
+		free(real);
+		return 0;
+	}
+
+	uint64_t h = memo_hash(MEMO_FNV_BASIS, real, strlen(real) + 1);
+	int64_t identity[3] = { st.st_size, st.st_mtim.tv_sec, st.st_mtim.tv_nsec };
+	h = memo_hash(h, identity, sizeof(identity));
+
+	int i;
+	for (i = 0; i < table_count; i++) h = memo_hash(h, tables[i], strlen(tables[i]) + 1);
+	*key = memo_hash(h, options, strlen(options) + 1);
+
+	free(real);
+
+	return 1;
+}
+
+uint64_t memo_target_key(memo_cache* memo, lookup_target* t) {
+	// Every NAN time (no time given) keys the same
+	double time = isnan(t->time) ? 0 : t->time;
+	uint64_t h = memo_hash(memo->query, &t->lat, sizeof(float));
+	h = memo_hash(h, &t->lon, sizeof(float));
+	return memo_hash(h, &time, sizeof(double));
+}
+
+memo_cache* open_memo_cache(const char* spec) {
+
+	char* file = strdup(spec);
+	size_t mb = MEMO_DEFAULT_MB;
+
+	char* sep = strrchr(file, ':');
+	if (sep != NULL) {
+		char* end;
+		mb = strtoul(sep + 1, &end, 10);
+		if (end == sep + 1 || *end != 0 || mb == 0) {
+			free(file);
+			return NULL;
+		}
+		*sep = 0;
+	}
+
+	uint64_t slots = mb * 1024 * 1024 / sizeof(memo_slot) / MEMO_WAYS * MEMO_WAYS;
+	size_t bytes = sizeof(memo_header) + slots * sizeof(memo_slot);
+
+	int fd = open(file, O_RDWR | O_CREAT, 0644);
+	if (fd < 0 || slots == 0) {
+		if (fd >= 0) close(fd);
+		free(file);
+		return NULL;
+	}
+
+	flock(fd, LOCK_EX);
+
+	struct stat st;
+	memo_header header;
+	int current = fstat(fd, &st) == 0 && (size_t) st.st_size == bytes
+		&& pread(fd, &header, sizeof(memo_header), 0) == sizeof(memo_header)
+		&& header.magic == MEMO_MAGIC && header.slots == slots;
+
+	// Another size or layout, a new file with every slot empty replaces it
+	if (!current) {
+		memset(&header, 0, sizeof(memo_header));
+		header.magic = MEMO_MAGIC;
+		header.slots = slots;
+
+		char* tmp = malloc(strlen(file) + 16);
+		sprintf(tmp, "%s.%d", file, (int) getpid());
+
+		int new_fd = open(tmp, O_RDWR | O_CREAT | O_TRUNC, 0644);
+		current = new_fd >= 0 && ftruncate(new_fd, bytes) == 0 && pwrite(new_fd, &header, sizeof(memo_header), 0) == sizeof(memo_header)
+			&& flock(new_fd, LOCK_EX) == 0 && rename(tmp, file) == 0;
+
+		if (!current) {
+			if (new_fd >= 0) close(new_fd);
+			remove(tmp);
+		} else {
+			flock(fd, LOCK_UN);
+			close(fd);
+			fd = new_fd;
+		}
+
+		free(tmp);
+	}
+
+	void* map = current ? mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+
+	flock(fd, LOCK_UN);
+	free(file);
+
+	if (map == MAP_FAILED) {
+		close(fd);
+		return NULL;
+	}
+
+	memo_cache* memo = calloc(1, sizeof(memo_cache));
+	memo->fd = fd;
+	memo->bytes = bytes;
+	memo->header = (memo_header*) map;
+	memo->slots = (memo_slot*) ((char*) map + sizeof(memo_header));
+	memo->sets = slots / MEMO_WAYS;
+
+	if (DEBUG_MEMO) printf("memo cache: %lu slots\n", (unsigned long) slots);
+
+	return memo;
+}
+
+// Set of the key, NULL slot when not cached
+memo_slot* memo_find(memo_cache* memo, uint64_t target, memo_slot** set) {
+
+	*set = &memo->slots[(target % memo->sets) * MEMO_WAYS];
+
+	int w;
+	for (w = 0; w < MEMO_WAYS; w++) {
+		memo_slot* slot = &(*set)[w];
+		if (slot->used != 0 && slot->query == memo->query && slot->target == target) return slot;
+	}
+
+	return NULL;
+}
+
+// A new string per cached target ("" for no match), NULL for the others
+char** memo_lookup(memo_cache* memo, uint64_t query, lookup_target* targets, int count) {
+
+	memo->query = query;
+
+	char** lines = calloc(count > 0 ? count : 1, sizeof(char*));
+
+	flock(memo->fd, LOCK_EX);
+
+	int i;
+	for (i = 0; i < count; i++) {
+		memo_slot* set;
+		memo_slot* slot = memo_find(memo, memo_target_key(memo, &targets[i]), &set);
+
+		if (slot == NULL) {
+			stats.memo_misses++;
+			continue;
+		}
+
+		slot->used = ++memo->header->clock;
+		lines[i] = strndup(slot->line, slot->length);
+		stats.memo_hits++;
+	}
+
+	flock(memo->fd, LOCK_UN);
+
+	return lines;
+}
+
+void memo_store(memo_cache* memo, lookup_target* t, const char* line) {
+
+	size_t length = strlen(line);
+	if (length > MEMO_LINE_LEN) return;
+
+	uint64_t target = memo_target_key(memo, t);
+
+	flock(memo->fd, LOCK_EX);
+
+	memo_slot* set;
+	memo_slot* slot = memo_find(memo, target, &set);
+
+	// Or the least recently used of the set, empty slots first
+	if (slot == NULL) {
+		slot = &set[0];
+		int w;
+		for (w = 1; w < MEMO_WAYS; w++) {
+			if (set[w].used < slot->used) slot = &set[w];
+		}
+		if (slot->used != 0) stats.memo_evicted++;
+	}
+
+	slot->query = memo->query;
+	slot->target = target;
+	slot->used = ++memo->header->clock;
+	slot->length = length;
+	memcpy(slot->line, line, length);
+
+	flock(memo->fd, LOCK_UN);
+}
+
+void close_memo_cache(memo_cache* memo) {
+	if (memo == NULL) return;
+	munmap(memo->header, memo->bytes);
+	close(memo->fd);
+	free(memo);
+}
@@ -0,0 +1,239 @@
+/*
+ *	Program: HDF5 Lookup v0.1
+ *
+ *	Usage: This code is free to use and modify, so long
+ *		as this header remains intact, except for
+ *		"Modifications" below.
+ *
+ *	Purpose: Brute force nearest pixel search over whole lat/lon tables.
+ *
+ *		One kernel per storage type is generated by GEO_NEAREST_KERNEL,
+ *		so the inner loop indexes the tables in their own type and
+ *		decodes inline. Validity comes from the packed bitmap (validity.c)
+ *		instead of a fill test per pixel: words with no valid pixel are
+ *		skipped, fully valid words run as a plain loop without a branch
+ *		on the data, and partly valid words visit only their set bits.
+ *		Pixels are still visited in row-major order, so ties resolve to
+ *		the same pixel as before.
+ *
+ *		Packed tables (-z, packed.c) are decoded a block, one validity
+ *		word, at a time into a buffer, blocks without a valid pixel are
+ *		never decoded.
+ *
+ *		Tables of mixed storage go through the generic (slower)
+ *		geo_value kernel.
+ *
+ *		Time aware searches (-t, scantime.c) rank pixels by space and
+ *		time through a per row penalty, and only visit the rows of the
+ *		scans inside the time window.
+ *
+ *	Functions
+ *		void*		get_indices_from_geo_tables	- returns { row, col, distance }
+ *		void*		get_indices_from_geo_timed	- returns { row, col, distance }, ranked with row penalties
+ *
+ *	Modifications:
+ *		2026 10 18 - Initial Version (kernels from geotable.c)
+ *		2026 10 18 - Space/time search over the rows of a time window
+ *		2026 10 18 - Packed kernel, decoded per block
+ */
+
+// Decode one stored (valid) value
+#define GEO_DECODE(RAW, SCALED, SCALE, OFFSET) ((SCALED) ? (RAW) * (SCALE) + (OFFSET) : (double) (RAW))
+
+#define GEO_NEAREST_PIXEL(COL, SCALED) { \
+	double lat = GEO_DECODE(row_lat[COL], SCALED, scale_lat, offset_lat); \
+	double lon = GEO_DECODE(row_lon[COL], SCALED, scale_lon, offset_lon); \
+	double distance = gc_distance(lat, lon, target_lat, target_lon); \
+	if (closest > distance) { \
+		closest_row = row; \
+		closest_col = (COL); \
+		closest = distance; \
+	} \
+}
+
+// Nearest valid pixel over tables of one storage TYPE. SCALED is a
+// constant, so float kernels compile without the integer decode.
+#define GEO_NEAREST_KERNEL(NAME, TYPE, SCALED) \
+void* NAME(geo_table* t_lat, geo_table* t_lon, validity_mask* mask, double target_lat, double target_lon) { \
+	\
+	double scale_lat = t_lat->scale, offset_lat = t_lat->offset; \
+	double scale_lon = t_lon->scale, offset_lon = t_lon->offset; \
+	\
+	double closest = 99999; \
+	int closest_row = -9999; \
+	int closest_col = -9999; \
+	\
+	int row, w, col; \
+	for (row = 0; row < mask->rows; row++) { \
+		\
+		TYPE* row_lat = ((TYPE**) t_lat->data)[row]; \
+		TYPE* row_lon = ((TYPE**) t_lon->data)[row]; \
+		uint64_t* words = &mask->words[(size_t) row * mask->words_per_row]; \
+		\
+		for (w = 0; w < mask->words_per_row; w++) { \
+			\
+			uint64_t bits = words[w]; \
+			int base = w * 64; \
+			\
+			if (bits == 0) continue; \
+			\
+			if (bits == VALIDITY_FULL_WORD) { \
+				for (col = base; col < base + 64; col++) GEO_NEAREST_PIXEL(col, SCALED) \
+			} else { \
+				while (bits != 0) { \
+					col = base + __builtin_ctzll(bits); \
+					bits &= bits - 1; \
+					GEO_NEAREST_PIXEL(col, SCALED) \
+				} \
+			} \
+		} \
+	} \
+	\
+	int* ret_vals = malloc(sizeof(int) * 3); \
+	ret_vals[0] = closest_row; \
+	ret_vals[1] = closest_col; \
+	ret_vals[2] = closest; \
+	\
+	return (void*) ret_vals; \
+}
+
+GEO_NEAREST_KERNEL(get_indices_from_float32, float, 0)
+GEO_NEAREST_KERNEL(get_indices_from_float64, double, 0)
+GEO_NEAREST_KERNEL(get_indices_from_int16, short, 1)
+GEO_NEAREST_KERNEL(get_indices_from_uint16, unsigned short, 1)
+GEO_NEAREST_KERNEL(get_indices_from_int32, int, 1)
+
+// Packed tables, PACKED_BLOCK is one validity word
+void* get_indices_from_packed(geo_table* t_lat, geo_table* t_lon, validity_mask* mask, double target_lat, double target_lon) {
+
+	packed_table* p_lat = (packed_table*) t_lat->data;
+	packed_table* p_lon = (packed_table*) t_lon->data;
+	double block_lat[PACKED_BLOCK], block_lon[PACKED_BLOCK];
+
+	double closest = 99999;
+	int closest_row = -9999;
+	int closest_col = -9999;
+
+	int row, w, k;
+	for (row = 0; row < mask->rows; row++) {
+
+		uint64_t* words = &mask->words[(size_t) row * mask->words_per_row];
+
+		for (w = 0; w < mask->words_per_row; w++) {
+
+			uint64_t bits = words[w];
+			if (bits == 0) continue;
+
+			unpack_block(p_lat, row, w, block_lat);
+			unpack_block(p_lon, row, w, block_lon);
+
+			while (bits != 0) {
+				k = __builtin_ctzll(bits);
+				bits &= bits - 1;
+
+				double distance = gc_distance(block_lat[k], block_lon[k], target_lat, target_lon);
+
+				if (closest > distance) {
+					closest_row = row;
+					closest_col = w * 64 + k;
+					closest = distance;
+				}
+			}
+		}
+	}
+
+	int* ret_vals = malloc(sizeof(int) * 3);
+	ret_vals[0] = closest_row;
+	ret_vals[1] = closest_col;
+	ret_vals[2] = closest;
+
+	return (void*) ret_vals;
+}
+
+// Mixed storage, every valid pixel decoded through geo_value
+void* get_indices_from_geo_values(geo_table* t_lat, geo_table* t_lon, validity_mask* mask, double target_lat, double target_lon) {
+
+	double closest = 99999;
+	int closest_row = -9999;
+	int closest_col = -9999;
+
+	int row, col;
+	for (row = 0; row < mask->rows; row++) {
+		for (col = 0; col < mask->cols; col++) {
+
+			if (!validity_test(mask, row, col)) continue;
+
+			double lat = geo_value(t_lat, row, col);
+			double lon = geo_value(t_lon, row, col);
+
+			double distance = gc_distance(lat, lon, target_lat, target_lon);
+
+			if (closest > distance) {
+				closest_row = row;
+				closest_col = col;
+				closest = distance;
+			}
+		}
+	}
+
+	int* ret_vals = malloc(sizeof(int) * 3);
+	ret_vals[0] = closest_row;
+	ret_vals[1] = closest_col;
+	ret_vals[2] = closest;
+
+	return (void*) ret_vals;
+}
+
+// Rows with a penalty below 0 are skipped, the others rank by sqrt(distance^2 + penalty^2)
+void* get_indices_from_geo_timed(geo_table* t_lat, geo_table* t_lon, validity_mask* mask, const double* row_penalty, double target_lat, double target_lon) {
+
+	double closest = 99999;
+	int closest_row = -9999;
+	int closest_col = -9999;
+
+	int row, w, col;
+	for (row = 0; row < mask->rows; row++) {
+
+		if (row_penalty[row] < 0) continue;
+
+		uint64_t* words = &mask->words[(size_t) row * mask->words_per_row];
+
+		for (w = 0; w < mask->words_per_row; w++) {
+
+			uint64_t bits = words[w];
+			while (bits != 0) {
+				col = w * 64 + __builtin_ctzll(bits);
+				bits &= bits - 1;
+
+				double distance = hypot(gc_distance(geo_value(t_lat, row, col), geo_value(t_lon, row, col), target_lat, target_lon), row_penalty[row]);
+
+				if (closest > distance) {
+					closest_row = row;
+					closest_col = col;
+					closest = distance;
+				}
+			}
+		}
+	}
+
+	int* ret_vals = malloc(sizeof(int) * 3);
+	ret_vals[0] = closest_row;
+	ret_vals[1] = closest_col;
+	ret_vals[2] = closest;
+
+	return (void*) ret_vals;
+}
+
+void* get_indices_from_geo_tables(geo_table* t_lat, geo_table* t_lon, validity_mask* mask, double target_lat, double target_lon) {
+
+	if (t_lat->storage != t_lon->storage) return get_indices_from_geo_values(t_lat, t_lon, mask, target_lat, target_lon);
+
+	switch (t_lat->storage) {
+		case GEO_FLOAT32:	return get_indices_from_float32(t_lat, t_lon, mask, target_lat, target_lon);
+		case GEO_FLOAT64:	return get_indices_from_float64(t_lat, t_lon, mask, target_lat, target_lon);
+		case GEO_INT16:		return get_indices_from_int16(t_lat, t_lon, mask, target_lat, target_lon);
+		case GEO_UINT16:	return get_indices_from_uint16(t_lat, t_lon, mask, target_lat, target_lon);
+		case GEO_PACKED:	return get_indices_from_packed(t_lat, t_lon, mask, target_lat, target_lon);
+		default:			return get_indices_from_int32(t_lat, t_lon, mask, target_lat, target_lon);
+	}
+}
@@ -0,0 +1,347 @@
+/*
+ *	Program: HDF5 Lookup v0.1
+ *
+ *	Usage: This code is free to use and modify, so long
+ *		as this header remains intact, except for
+ *		"Modifications" below.
+ *
+ *	Purpose: Orbit file (-V -o Orbit.h5), an HDF5 virtual dataset (VDS)
+ *		per table stitching the granules of a -G style list along the
+ *		first (track) dimension. Lookups then open Orbit.h5 as File,
+ *		one open per orbit instead of one per granule.
+ *
+ *		Every table keeps its path, type and attributes (taken from the
+ *		first granule), the other dimensions must match across granules.
+ *		Granules are mapped in list order, each a block of rows, so 1-d
+ *		per scan tables such as MidTime stitch the same way as Latitude.
+ *		Source files are recorded by absolute path.
+ *
+ *		HDF5 opens a source file only when a selection reaches its rows.
+ *		A target lookup on Orbit.h5 takes the LatTable/LonTable mappings
+ *		back to the granules (orbit_granule_list) and searches them as a
+ *		-G swath (virtual.c): footprints first, then only the granules
+ *		home to a target are read whole, and their variables read from
+ *		them. This needs the mappings of both tables to be the same
+ *		whole-width blocks of rows from absolute source paths, and the
+ *		options -G takes; other virtual tables and options read the whole
+ *		geolocation through the file, with variable reads taking the
+ *		mapping blocks as their "chunks" (extract.c), one point selection
+ *		per granule holding a located target.
+ *
+ *	Functions
+ *		int				build_orbit_file	- virtual datasets of the tables over a granule list
+ *		granule_list*	orbit_granule_list	- the granules under a LatTable/LonTable orbit, NULL for other files
+ *
+ *	Modifications:
+ *		2026 10 18 - Initial Version
+ *		2026 10 18 - Orbit lookups searched per granule (orbit_granule_list)
+ */
+
+#define DEBUG_ORBIT 0
+
+// Attributes of the first granule's dataset, copied onto the virtual one
+herr_t copy_orbit_attribute(hid_t src_varid, const char* name, const H5A_info_t* info, void* op_data) {
+
+	hid_t dst_varid = *(hid_t*) op_data;
+
+	hid_t attr = H5Aopen(src_varid, name, H5P_DEFAULT);
+	hid_t type = H5Aget_type(attr);
+	hid_t space = H5Aget_space(attr);
+
+	hssize_t points = H5Sget_simple_extent_npoints(space);
+	void* buffer = calloc(points > 0 ? points : 1, H5Tget_size(type));
+
+	if (H5Aread(attr, type, buffer) >= 0) {
+		hid_t copy = H5Acreate(dst_varid, name, type, space, H5P_DEFAULT, H5P_DEFAULT);
+		H5Awrite(copy, type, buffer);
+		H5Aclose(copy);
+
+		if (H5Tdetect_class(type, H5T_VLEN) > 0 || H5Tis_variable_str(type) > 0) H5Dvlen_reclaim(type, space, H5P_DEFAULT, buffer);
+	}
+
+	free(buffer);
+	H5Sclose(space);
+	H5Tclose(type);
+	H5Aclose(attr);
+
+	return 0;
+}
+
+// One virtual dataset, granule g mapped to its block of rows
+int build_orbit_table(hid_t out_h5id, granule_list* gl, char** sources, const char* table) {
+
+	char *group, *name;
+	split_table_path(table, &group, &name);
+
+	hid_t first_h5id = -1, first_varid = -1;
+	hid_t type = -1;
+	int rank = 0, ok = 1, g, d;
+	hsize_t dims[MAX_DIMS], total[MAX_DIMS];
+	hsize_t* granule_rows = calloc(gl->count, sizeof(hsize_t));
+
+	// Extents, every granule has to agree past the first dimension
+	for (g = 0; g < gl->count && ok; g++) {
+		hid_t* ids     = (hid_t*) get_variable_ids_by_name(gl->paths[g], group, name);
+		hid_t h5id     = ids[0];
+		hid_t grp_h5id = ids[1];
+		hid_t varid    = ids[2];
+		free(ids);
+
+		if (varid < 0) {
+			fprintf(stderr, "%s has no %s\n", gl->paths[g], table);
+			ok = 0;
+		} else {
+			hid_t space = H5Dget_space(varid);
+			int granule_rank = H5Sget_simple_extent_ndims(space);
+			if (granule_rank >= 1 && granule_rank <= MAX_DIMS) H5Sget_simple_extent_dims(space, dims, NULL);
+			H5Sclose(space);
+
+			hid_t granule_type = H5Dget_type(varid);
+
+			if (g == 0) {
+				rank = granule_rank;
+				type = H5Tcopy(granule_type);
+				for (d = 0; d < rank; d++) total[d] = dims[d];
+				total[0] = 0;
+			}
+
+			if (granule_rank != rank || rank < 1 || rank > MAX_DIMS || !H5Tequal(granule_type, type)) ok = 0;
+			for (d = 1; d < rank && ok; d++) if (dims[d] != total[d]) ok = 0;
+			if (!ok) fprintf(stderr, "%s of %s does not match the type or extent of %s\n", table, gl->paths[g], gl->paths[0]);
+
+			H5Tclose(granule_type);
+
+			granule_rows[g] = dims[0];
+			total[0] += dims[0];
+		}
+
+		H5Gclose(grp_h5id);
+
+		// The first dataset is kept open for its attributes
+		if (g == 0) {
+			first_h5id = h5id;
+			first_varid = varid;
+		} else {
+			if (varid >= 0) H5Dclose(varid);
+			H5Fclose(h5id);
+		}
+	}
+
+	if (ok) {
+		hid_t dcpl = H5Pcreate(H5P_DATASET_CREATE);
+		hid_t vspace = H5Screate_simple(rank, total, NULL);
+
+		// Unmapped rows read as the _FillValue, when it is of the table's own type
+		if (H5Aexists(first_varid, "_FillValue") > 0) {
+			hid_t attr = H5Aopen(first_varid, "_FillValue", H5P_DEFAULT);
+			hid_t attr_type = H5Aget_type(attr);
+			void* fill = calloc(1, H5Tget_size(type));
+
+			if (H5Tequal(attr_type, type) && H5Aread(attr, type, fill) >= 0) H5Pset_fill_value(dcpl, type, fill);
+
+			free(fill);
+			H5Tclose(attr_type);
+			H5Aclose(attr);
+		}
+
+		hsize_t start[MAX_DIMS] = { 0 };
+		hsize_t count[MAX_DIMS];
+		for (d = 0; d < rank; d++) count[d] = total[d];
+
+		for (g = 0; g < gl->count && ok; g++) {
+			count[0] = granule_rows[g];
+			if (count[0] == 0) continue;
+
+			hid_t src_space = H5Screate_simple(rank, count, NULL);
+			H5Sselect_hyperslab(vspace, H5S_SELECT_SET, start, NULL, count, NULL);
+
+			ok = H5Pset_virtual(dcpl, vspace, sources[g], table, src_space) >= 0;
+
+			H5Sclose(src_space);
+			start[0] += granule_rows[g];
+		}
+		H5Sselect_all(vspace);
+
+		// Same path as in the granules, so the lookup command line is unchanged
+		hid_t lcpl = H5Pcreate(H5P_LINK_CREATE);
+		H5Pset_create_intermediate_group(lcpl, 1);
+
+		hid_t varid = ok ? H5Dcreate(out_h5id, table, type, vspace, lcpl, dcpl, H5P_DEFAULT) : -1;
+		if (varid >= 0) {
+			H5Aiterate2(first_varid, H5_INDEX_NAME, H5_ITER_NATIVE, NULL, copy_orbit_attribute, &varid);
+			H5Dclose(varid);
+		} else {
+			ok = 0;
+		}
+
+		if (DEBUG_ORBIT) printf("orbit %s: %d granules, %d dims, %lu rows, ok %d\n", table, gl->count, rank, (unsigned long) total[0], ok);
+
+		H5Pclose(lcpl);
+		H5Sclose(vspace);
+		H5Pclose(dcpl);
+	}
+
+	if (first_varid >= 0) H5Dclose(first_varid);
+	if (first_h5id >= 0) H5Fclose(first_h5id);
+	if (type >= 0) H5Tclose(type);
+
+	free(granule_rows);
+	free(group);
+	free(name);
+
+	return ok;
+}
+
+int build_orbit_file(const char* out, granule_list* gl, char** tables, int table_count) {
+
+	// Absolute source paths, the orbit file may be opened from anywhere
+	char** sources = malloc(sizeof(char*) * gl->count);
+	int g, i, ok = 1;
+	for (g = 0; g < gl->count; g++) {
+		sources[g] = realpath(gl->paths[g], NULL);
+		if (sources[g] == NULL) {
+			fprintf(stderr, "Unable to find %s\n", gl->paths[g]);
+			ok = 0;
+		}
+	}
+
+	hid_t h5id = ok ? H5Fcreate(out, H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT) : -1;
+
+	if (h5id >= 0) {
+		for (i = 0; i < table_count && ok; i++) ok = build_orbit_table(h5id, gl, sources, tables[i]);
+		H5Fclose(h5id);
+	} else {
+		ok = 0;
+	}
+
+	for (g = 0; g < gl->count; g++) free(sources[g]);
+	free(sources);
+
+	return ok;
+}
+
+// Mappings of one table: absolute source path and first row per whole-width block, in row order
+int orbit_table_blocks(const char* path, const char* table, char*** sources, hsize_t** rows, hsize_t** counts) {
+
+	char *group, *name;
+	split_table_path(table, &group, &name);
+
+	hid_t* ids     = (hid_t*) get_variable_ids_by_name(path, group, name);
+	hid_t h5id     = ids[0];
+	hid_t grp_h5id = ids[1];
+	hid_t varid    = ids[2];
+	free(ids);
+	free(group);
+	free(name);
+
+	size_t count = 0;
+	int ok = varid >= 0;
+
+	hid_t dcpl = ok ? H5Dget_create_plist(varid) : -1;
+	ok = ok && H5Pget_layout(dcpl) == H5D_VIRTUAL && H5Pget_virtual_count(dcpl, &count) >= 0 && count > 0;
+
+	hsize_t dims[MAX_DIMS];
+	if (ok) {
+		hid_t space = H5Dget_space(varid);
+		ok = H5Sget_simple_extent_ndims(space) == 2;
+		if (ok) H5Sget_simple_extent_dims(space, dims, NULL);
+		H5Sclose(space);
+	}
+
+	*sources = calloc(count > 0 ? count : 1, sizeof(char*));
+	*rows = calloc(count > 0 ? count : 1, sizeof(hsize_t));
+	*counts = calloc(count > 0 ? count : 1, sizeof(hsize_t));
+
+	size_t k;
+	for (k = 0; k < count && ok; k++) {
+		hid_t vspace = H5Pget_virtual_vspace(dcpl, k);
+		hsize_t start[MAX_DIMS], end[MAX_DIMS];
+
+		ok = H5Sget_select_type(vspace) == H5S_SEL_HYPERSLABS && H5Sget_select_bounds(vspace, start, end) >= 0
+			&& start[1] == 0 && end[1] == dims[1] - 1
+			&& (hsize_t) H5Sget_select_npoints(vspace) == (end[0] - start[0] + 1) * dims[1]
+			&& (k == 0 || start[0] >= (*rows)[k - 1] + (*counts)[k - 1]);
+
+		(*rows)[k] = start[0];
+		(*counts)[k] = end[0] - start[0] + 1;
+		H5Sclose(vspace);
+
+		// All of the source, the granule searched is the whole table
+		hid_t src_space = ok ? H5Pget_virtual_srcspace(dcpl, k) : -1;
+		ok = ok && H5Sget_select_type(src_space) == H5S_SEL_ALL;
+		if (src_space >= 0) H5Sclose(src_space);
+
+		// The source has to be another file, by absolute path, holding the same table
+		ssize_t length = ok ? H5Pget_virtual_filename(dcpl, k, NULL, 0) : -1;
+		ssize_t dset_length = ok ? H5Pget_virtual_dsetname(dcpl, k, NULL, 0) : -1;
+		ok = length > 0 && dset_length > 0;
+
+		if (ok) {
+			char* source = malloc(length + 1);
+			char* dset = malloc(dset_length + 1);
+			H5Pget_virtual_filename(dcpl, k, source, length + 1);
+			H5Pget_virtual_dsetname(dcpl, k, dset, dset_length + 1);
+
+			ok = source[0] == '/' && strcmp(dset, table) == 0;
+
+			(*sources)[k] = source;
+			free(dset);
+		}
+	}
+
+	if (dcpl >= 0) H5Pclose(dcpl);
+	if (varid >= 0) H5Dclose(varid);
+	if (grp_h5id >= 0) H5Gclose(grp_h5id);
+	if (h5id >= 0) H5Fclose(h5id);
+
+	if (!ok) {
+		for (k = 0; k < count; k++) free((*sources)[k]);
+		count = 0;
+	}
+
+	return (int) count;
+}
+
+granule_list* orbit_granule_list(const char* path, const char* lat_table, const char* lon_table) {
+
+	char **lat_sources, **lon_sources;
+	hsize_t *lat_rows, *lon_rows, *lat_counts, *lon_counts;
+
+	int count = orbit_table_blocks(path, lat_table, &lat_sources, &lat_rows, &lat_counts);
+	int lon_count = count > 0 ? orbit_table_blocks(path, lon_table, &lon_sources, &lon_rows, &lon_counts) : 0;
+
+	int ok = count > 0 && lon_count == count, g;
+	for (g = 0; g < count && ok; g++) {
+		ok = strcmp(lat_sources[g], lon_sources[g]) == 0 && lat_rows[g] == lon_rows[g] && lat_counts[g] == lon_counts[g];
+	}
+
+	granule_list* gl = NULL;
+	if (ok) {
+		gl = calloc(1, sizeof(granule_list));
+		gl->count = count;
+		gl->paths = malloc(sizeof(char*) * count);
+		gl->bounds = malloc(sizeof(double) * 4 * count);
+		gl->rows = calloc(count, sizeof(int));
+		gl->cols = calloc(count, sizeof(int));
+
+		for (g = 0; g < count; g++) {
+			gl->paths[g] = strdup(lat_sources[g]);
+			gl->bounds[4 * g] = gl->bounds[4 * g + 1] = gl->bounds[4 * g + 2] = gl->bounds[4 * g + 3] = NAN;
+		}
+	}
+
+	if (DEBUG_ORBIT) printf("orbit %s: %d granules (%d lon), searched per granule %d\n", path, count, lon_count, ok);
+
+	for (g = 0; g < count; g++) free(lat_sources[g]);
+	for (g = 0; g < lon_count; g++) free(lon_sources[g]);
+	free(lat_sources);
+	free(lat_rows);
+	free(lat_counts);
+	if (count > 0) {
+		free(lon_sources);
+		free(lon_rows);
+		free(lon_counts);
+	}
+
+	return gl;
+}
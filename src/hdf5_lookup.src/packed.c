@@ -0,0 +1,217 @@
+/*
+ *	Program: HDF5 Lookup v0.1
+ *
+ *	Usage: This code is free to use and modify, so long
+ *		as this header remains intact, except for
+ *		"Modifications" below.
+ *
+ *	Purpose: Packed geolocation (-z), a lat or lon table held as
+ *		quantized fixed-point values for the resident searches, about a
+ *		third the size of float tables (a sixth of double).
+ *
+ *		Values are quantized to PACKED_QUANTUM degrees, so a decoded
+ *		value is within PACKED_QUANTUM / 2 (0.22 m) of the stored one.
+ *		Each row is cut into blocks of PACKED_BLOCK columns, one validity
+ *		word (validity.c). A block keeps a base and a slope, the line
+ *		through its first and last valid pixels, and per column the
+ *		residual from that line in the fewest bytes holding them all (1,
+ *		2 or 4). Along a scan line neighbouring pixels are nearly evenly
+ *		spaced, so almost every block takes a byte per pixel; blocks
+ *		across the dateline or with odd pixels take wider residuals and
+ *		stay exact to the quantum.
+ *
+ *		Missing values (NAN, or outside +-PACKED_RANGE) are the lowest
+ *		residual of the block's width and decode to NAN.
+ *
+ *		Any value decodes on its own (packed_value), the search kernels
+ *		decode a whole block at a time (unpack_block, nearest.c).
+ *
+ *	Functions
+ *		packed_table*	new_packed_table	- empty table, rows are packed in order
+ *		void			pack_row			- quantize and append one row
+ *		double			packed_value		- one decoded value, NAN if missing
+ *		int				unpack_block		- decoded values of one block, NAN if missing
+ *		size_t			packed_table_bytes	- memory held by a table
+ *		void			free_packed_table
+ *
+ *	Modifications:
+ *		2026 10 18 - Initial Version
+ */
+
+#define DEBUG_PACKED 0
+
+#define PACKED_BLOCK 64
+#define PACKED_QUANTUM 4e-6			// degrees
+#define PACKED_RANGE 1000.			// degrees, larger values are missing
+#define PACKED_SLOPE_BITS 8			// slope fraction, quanta per column
+
+typedef struct {
+	int32_t base;				// quanta at column 0 of the block
+	int32_t slope;				// quanta per column << PACKED_SLOPE_BITS
+	uint32_t offset;			// first residual byte
+	int32_t width;				// bytes per residual
+} packed_block;
+
+typedef struct {
+	int rows;
+	int cols;
+	int blocks_per_row;
+	int packed_rows;
+	packed_block* blocks;		// rows * blocks_per_row
+	uint8_t* residuals;
+	size_t length;				// residual bytes used
+	size_t allocated;
+} packed_table;
+
+// Line through the block's first and last valid pixels, k columns in
+#define PACKED_PREDICT(BLOCK, K) ((BLOCK)->base + (int32_t) (((int64_t) (BLOCK)->slope * (K)) / (1 << PACKED_SLOPE_BITS)))
+
+packed_table* new_packed_table(int rows, int cols) {
+
+	packed_table* pt = calloc(1, sizeof(packed_table));
+	pt->rows = rows;
+	pt->cols = cols;
+	pt->blocks_per_row = (cols + PACKED_BLOCK - 1) / PACKED_BLOCK;
+	pt->blocks = calloc((size_t) rows * pt->blocks_per_row, sizeof(packed_block));
+	pt->allocated = (size_t) rows * cols + PACKED_BLOCK;
+	pt->residuals = malloc(pt->allocated);
+
+	return pt;
+}
+
+void free_packed_table(packed_table* pt) {
+	if (pt == NULL) return;
+	free(pt->blocks);
+	free(pt->residuals);
+	free(pt);
+}
+
+size_t packed_table_bytes(packed_table* pt) {
+	return (size_t) pt->rows * pt->blocks_per_row * sizeof(packed_block) + pt->length;
+}
+
+// Rows have to be packed in order, values has cols entries
+void pack_row(packed_table* pt, int row, const double* values) {
+
+	int32_t quanta[PACKED_BLOCK];
+	int missing[PACKED_BLOCK];
+	int32_t residual[PACKED_BLOCK];
+
+	int b, k;
+	for (b = 0; b < pt->blocks_per_row; b++) {
+
+		packed_block* block = &pt->blocks[(size_t) row * pt->blocks_per_row + b];
+		int col0 = b * PACKED_BLOCK;
+		int n = pt->cols - col0 < PACKED_BLOCK ? pt->cols - col0 : PACKED_BLOCK;
+
+		int first = -1, last = -1;
+		for (k = 0; k < n; k++) {
+			double value = values[col0 + k];
+			missing[k] = isnan(value) || fabs(value) > PACKED_RANGE;
+			if (missing[k]) continue;
+
+			quanta[k] = (int32_t) lround(value / PACKED_QUANTUM);
+			if (first < 0) first = k;
+			last = k;
+		}
+
+		// A slope too steep for the fraction (no neighbour is that far) is left flat
+		block->base = 0;
+		block->slope = 0;
+		if (first >= 0 && last > first) {
+			int64_t slope = ((int64_t) quanta[last] - quanta[first]) * (1 << PACKED_SLOPE_BITS) / (last - first);
+			if (slope > INT32_MIN && slope <= INT32_MAX) block->slope = slope;
+		}
+		if (first >= 0) block->base = quanta[first] - PACKED_PREDICT(block, first);
+
+		// Residuals in the narrowest width, keeping its lowest value for missing
+		int32_t low = 0, high = 0;
+		for (k = 0; k < n; k++) {
+			if (missing[k]) continue;
+			residual[k] = quanta[k] - PACKED_PREDICT(block, k);
+			if (residual[k] < low) low = residual[k];
+			if (residual[k] > high) high = residual[k];
+		}
+
+		if (low > INT8_MIN && high <= INT8_MAX) block->width = 1;
+		else if (low > INT16_MIN && high <= INT16_MAX) block->width = 2;
+		else block->width = 4;
+
+		block->offset = pt->length;
+
+		if (pt->length + (size_t) n * block->width > pt->allocated) {
+			pt->allocated = pt->allocated * 2 + (size_t) n * block->width;
+			pt->residuals = realloc(pt->residuals, pt->allocated);
+		}
+
+		for (k = 0; k < n; k++) {
+			uint8_t* at = &pt->residuals[pt->length + (size_t) k * block->width];
+			if (block->width == 1) {
+				int8_t r = missing[k] ? INT8_MIN : residual[k];
+				memcpy(at, &r, 1);
+			} else if (block->width == 2) {
+				int16_t r = missing[k] ? INT16_MIN : residual[k];
+				memcpy(at, &r, 2);
+			} else {
+				int32_t r = missing[k] ? INT32_MIN : residual[k];
+				memcpy(at, &r, 4);
+			}
+		}
+
+		pt->length += (size_t) n * block->width;
+	}
+
+	pt->packed_rows = row + 1;
+
+	// Return the slack once the last row is in
+	if (pt->packed_rows == pt->rows && pt->length > 0) {
+		pt->residuals = realloc(pt->residuals, pt->length);
+		pt->allocated = pt->length;
+	}
+
+	if (DEBUG_PACKED && row == pt->rows - 1) printf("packed table %d x %d: %lu bytes\n", pt->rows, pt->cols, (unsigned long) packed_table_bytes(pt));
+}
+
+double packed_value(const packed_table* pt, int row, int col) {
+
+	const packed_block* block = &pt->blocks[(size_t) row * pt->blocks_per_row + col / PACKED_BLOCK];
+	int k = col % PACKED_BLOCK;
+	const uint8_t* at = &pt->residuals[block->offset + (size_t) k * block->width];
+
+	int32_t r;
+	if (block->width == 1) {
+		int8_t r8;
+		memcpy(&r8, at, 1);
+		if (r8 == INT8_MIN) return NAN;
+		r = r8;
+	} else if (block->width == 2) {
+		int16_t r16;
+		memcpy(&r16, at, 2);
+		if (r16 == INT16_MIN) return NAN;
+		r = r16;
+	} else {
+		memcpy(&r, at, 4);
+		if (r == INT32_MIN) return NAN;
+	}
+
+	return (PACKED_PREDICT(block, k) + r) * PACKED_QUANTUM;
+}
+
+// Fills values with the block's columns, returns how many
+int unpack_block(const packed_table* pt, int row, int b, double* values) {
+
+	const packed_block* block = &pt->blocks[(size_t) row * pt->blocks_per_row + b];
+	const uint8_t* at = &pt->residuals[block->offset];
+
+	int n = pt->cols - b * PACKED_BLOCK < PACKED_BLOCK ? pt->cols - b * PACKED_BLOCK : PACKED_BLOCK;
+
+	int k;
+	if (block->width == 1) {
+		const int8_t* r = (const int8_t*) at;
+		for (k = 0; k < n; k++) values[k] = r[k] == INT8_MIN ? NAN : (PACKED_PREDICT(block, k) + r[k]) * PACKED_QUANTUM;
+	} else {
+		for (k = 0; k < n; k++) values[k] = packed_value(pt, row, b * PACKED_BLOCK + k);
+	}
+
+	return n;
+}
@@ -0,0 +1,175 @@
+/*
+ *	Program: HDF5 Lookup v0.1
+ *
+ *	Usage: This code is free to use and modify, so long
+ *		as this header remains intact, except for
+ *		"Modifications" below.
+ *
+ *	Purpose: Asynchronous reads (-A depth), an I/O thread running read
+ *		jobs while the caller searches, e.g. the geolocation of the next
+ *		granule of a -G swath and the variables of the last one
+ *		(virtual.c).
+ *
+ *		Jobs wait in two bounded FIFO queues of depth jobs each, reads
+ *		the search is waiting for (IO_AHEAD) before reads of results
+ *		(IO_BEHIND). Submitting to a full queue blocks until the thread
+ *		takes a job, so at most depth reads are ahead of the search and
+ *		their data held. A job marks its done flag once finished,
+ *		io_wait blocks on it.
+ *
+ *		HDF5 is not thread safe: the thread runs every job holding
+ *		hdf5_lock, callers reading with HDF5 meanwhile take it too
+ *		(io_hdf5_lock).
+ *
+ *		Depth 0 (no -A) has no thread, jobs run when submitted.
+ *
+ *	Functions
+ *		io_pipeline*	start_io_pipeline	- I/O thread with queues of depth jobs
+ *		void			io_submit			- queue fn(arg), done set once it ran
+ *		void			io_wait				- until a submitted job is done
+ *		void			io_hdf5_lock		- take turns with the I/O thread on HDF5
+ *		void			io_hdf5_unlock
+ *		void			finish_io_pipeline	- run the queued jobs and stop the thread
+ *
+ *	Modifications:
+ *		2026 10 18 - Initial Version
+ */
+
+#define DEBUG_PIPELINE 0
+
+#define IO_AHEAD 0					// reads the search waits for, run first
+#define IO_BEHIND 1					// reads of results
+#define IO_QUEUES 2
+
+typedef void (*io_job_fn)(void* arg);
+
+typedef struct {
+	io_job_fn fn;
+	void* arg;
+	volatile int* done;
+} io_job;
+
+typedef struct {
+	int depth;
+	io_job* queue[IO_QUEUES];	// depth jobs each, under lock
+	int head[IO_QUEUES];
+	int count[IO_QUEUES];
+	int stopping;
+	int threaded;
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t changed;		// a job queued, taken or done
+	pthread_mutex_t hdf5_lock;
+	size_t jobs;
+} io_pipeline;
+
+void* io_thread(void* arg) {
+
+	io_pipeline* p = (io_pipeline*) arg;
+
+	pthread_mutex_lock(&p->lock);
+	while (1) {
+		int q = p->count[IO_AHEAD] > 0 ? IO_AHEAD : IO_BEHIND;
+
+		if (p->count[q] == 0) {
+			if (p->stopping) break;
+			pthread_cond_wait(&p->changed, &p->lock);
+			continue;
+		}
+
+		io_job job = p->queue[q][p->head[q]];
+		p->head[q] = (p->head[q] + 1) % p->depth;
+		p->count[q]--;
+		pthread_cond_broadcast(&p->changed);
+		pthread_mutex_unlock(&p->lock);
+
+		pthread_mutex_lock(&p->hdf5_lock);
+		job.fn(job.arg);
+		pthread_mutex_unlock(&p->hdf5_lock);
+
+		pthread_mutex_lock(&p->lock);
+		*job.done = 1;
+		p->jobs++;
+		pthread_cond_broadcast(&p->changed);
+	}
+	pthread_mutex_unlock(&p->lock);
+
+	return NULL;
+}
+
+io_pipeline* start_io_pipeline(int depth) {
+
+	io_pipeline* p = calloc(1, sizeof(io_pipeline));
+	p->depth = depth > 0 ? depth : 0;
+	pthread_mutex_init(&p->lock, NULL);
+	pthread_cond_init(&p->changed, NULL);
+	pthread_mutex_init(&p->hdf5_lock, NULL);
+
+	if (p->depth > 0) {
+		int q;
+		for (q = 0; q < IO_QUEUES; q++) p->queue[q] = malloc(sizeof(io_job) * p->depth);
+		p->threaded = pthread_create(&p->thread, NULL, io_thread, p) == 0;
+	}
+
+	return p;
+}
+
+void io_submit(io_pipeline* p, int q, io_job_fn fn, void* arg, volatile int* done) {
+
+	*done = 0;
+
+	if (!p->threaded) {
+		fn(arg);
+		*done = 1;
+		p->jobs++;
+		return;
+	}
+
+	pthread_mutex_lock(&p->lock);
+	while (p->count[q] == p->depth) pthread_cond_wait(&p->changed, &p->lock);
+
+	io_job* job = &p->queue[q][(p->head[q] + p->count[q]) % p->depth];
+	job->fn = fn;
+	job->arg = arg;
+	job->done = done;
+	p->count[q]++;
+
+	pthread_cond_broadcast(&p->changed);
+	pthread_mutex_unlock(&p->lock);
+}
+
+void io_wait(io_pipeline* p, volatile int* done) {
+	pthread_mutex_lock(&p->lock);
+	while (!*done) pthread_cond_wait(&p->changed, &p->lock);
+	pthread_mutex_unlock(&p->lock);
+}
+
+void io_hdf5_lock(io_pipeline* p) {
+	pthread_mutex_lock(&p->hdf5_lock);
+}
+
+void io_hdf5_unlock(io_pipeline* p) {
+	pthread_mutex_unlock(&p->hdf5_lock);
+}
+
+void finish_io_pipeline(io_pipeline* p) {
+
+	if (p == NULL) return;
+
+	if (p->threaded) {
+		pthread_mutex_lock(&p->lock);
+		p->stopping = 1;
+		pthread_cond_broadcast(&p->changed);
+		pthread_mutex_unlock(&p->lock);
+		pthread_join(p->thread, NULL);
+	}
+
+	if (DEBUG_PIPELINE) printf("io pipeline: depth %d, %lu jobs\n", p->depth, (unsigned long) p->jobs);
+
+	int q;
+	for (q = 0; q < IO_QUEUES; q++) free(p->queue[q]);
+	pthread_mutex_destroy(&p->lock);
+	pthread_cond_destroy(&p->changed);
+	pthread_mutex_destroy(&p->hdf5_lock);
+	free(p);
+}
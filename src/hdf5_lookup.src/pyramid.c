@@ -0,0 +1,232 @@
+/*
+ *	Program: HDF5 Lookup v0.1
+ *
+ *	Usage: This code is free to use and modify, so long
+ *		as this header remains intact, except for
+ *		"Modifications" below.
+ *
+ *	Purpose: Coarse-to-fine search of full resolution geolocation
+ *		using strided hyperslab reads (-p N).
+ *
+ *		Latitude/Longitude are first read every Nth row and column.
+ *		The best PYRAMID_CANDIDATES samples are refined by reading
+ *		the window of +/- N pixels around each of them. Windows larger
+ *		than PYRAMID_MAX_WINDOW pixels are read strided again at
+ *		N / PYRAMID_REFINE, until the window is read at full resolution.
+ *		Only the coarse grid and a few small windows are ever read.
+ *
+ *	Functions
+ *		void		pyramid_value				- decoded lat/lon of one pixel
+ *		void*		get_indices_from_pyramid	- returns { row, col, distance }
+ *
+ *	Modifications:
+ *		2026 10 18 - Initial Version
+ *		2026 10 18 - Windows read in the stored type and decoded (geotable.c)
+ *		2026 10 18 - Quality flag mask (-q)
+ *		2026 10 18 - Windows filtered by their validity mask (validity.c)
+ */
+
+#define DEBUG_PYRAMID 0
+
+#define PYRAMID_CANDIDATES 3
+#define PYRAMID_REFINE 4
+#define PYRAMID_MAX_WINDOW 4096
+
+// Iterations allowed to walk the full resolution window when the best pixel is on its edge
+#define MAX_PYRAMID_WALK 8
+
+// Pixels from the window edge that still count as on it, flagged (-q) pixels can hide the edge itself
+#define PYRAMID_EDGE_MARGIN 4
+
+typedef struct {
+	const char* path;
+	const char* group_lat;
+	const char* name_lat;
+	const char* group_lon;
+	const char* name_lon;
+	int rows;
+	int cols;
+	double target_lat;
+	double target_lon;
+	size_t elements_read;
+	geo_table* t_lat;			// storage and scaling, data unused
+	geo_table* t_lon;
+	validity_mask* flag_mask;	// quality flags (-q), or NULL
+} pyramid_search;
+
+// Window of both tables in their stored type, decoded with geo_value
+void pyramid_read(pyramid_search* ps, const hsize_t* start, const hsize_t* step, const hsize_t* extent, geo_table* win_lat, geo_table* win_lon) {
+
+	*win_lat = *ps->t_lat;
+	*win_lon = *ps->t_lon;
+
+	win_lat->data = get_variable_hyperslab_by_name_dimalloc2(ps->path, ps->group_lat, ps->name_lat, ps->t_lat->mem_type, start, step, extent);
+	win_lon->data = get_variable_hyperslab_by_name_dimalloc2(ps->path, ps->group_lon, ps->name_lon, ps->t_lon->mem_type, start, step, extent);
+}
+
+void pyramid_value(pyramid_search* ps, int row, int col, double* lat, double* lon) {
+
+	hsize_t start[2] = { row, col };
+	hsize_t count[2] = { 1, 1 };
+
+	geo_table win_lat, win_lon;
+	pyramid_read(ps, start, NULL, count, &win_lat, &win_lon);
+
+	*lat = win_lat.data != NULL ? geo_value(&win_lat, 0, 0) : GEO_FILL;
+	*lon = win_lon.data != NULL ? geo_value(&win_lon, 0, 0) : GEO_FILL;
+
+	free(win_lat.data);
+	free(win_lon.data);
+}
+
+// Closest valid sample of a window read at stride, keeping the best 'count' samples sorted
+int pyramid_window(pyramid_search* ps, int row_lo, int row_hi, int col_lo, int col_hi, int stride, int count, int* best_row, int* best_col, double* best_dis) {
+
+	hsize_t start[2]  = { row_lo, col_lo };
+	hsize_t step[2]   = { stride, stride };
+	hsize_t extent[2] = { (row_hi - row_lo) / stride + 1, (col_hi - col_lo) / stride + 1 };
+
+	geo_table win_lat, win_lon;
+	pyramid_read(ps, start, step, extent, &win_lat, &win_lon);
+
+	win_lat.rows = win_lon.rows = extent[0];
+	win_lat.cols = win_lon.cols = extent[1];
+
+	ps->elements_read += 2 * extent[0] * extent[1];
+	stats.geolocation_elements += 2 * extent[0] * extent[1];
+
+	if (DEBUG_PYRAMID) printf("window rows %d-%d cols %d-%d stride %d (%d x %d)\n",
+		row_lo, row_hi, col_lo, col_hi, stride, (int) extent[0], (int) extent[1]);
+
+	int found = 0;
+	int i, j, k;
+
+	for (i = 0; i < count; i++) best_dis[i] = 99999;
+
+	if (win_lat.data != NULL && win_lon.data != NULL) {
+
+		// Same validity rule as the full table kernels, over just this window
+		validity_mask* mask = build_validity_mask(&win_lat, &win_lon);
+
+		for (i = 0; i < (int) extent[0]; i++) {
+			for (j = 0; j < (int) extent[1]; j++) {
+
+				if (!validity_test(mask, i, j)) continue;
+				if (ps->flag_mask != NULL && !validity_test(ps->flag_mask, row_lo + i * stride, col_lo + j * stride)) continue;
+
+				double distance = gc_distance(geo_value(&win_lat, i, j), geo_value(&win_lon, i, j), ps->target_lat, ps->target_lon);
+
+				if (distance < best_dis[count - 1]) {
+
+					// insertion into the sorted candidate list
+					for (k = count - 1; k > 0 && best_dis[k - 1] > distance; k--) {
+						best_dis[k] = best_dis[k - 1];
+						best_row[k] = best_row[k - 1];
+						best_col[k] = best_col[k - 1];
+					}
+					best_dis[k] = distance;
+					best_row[k] = row_lo + i * stride;
+					best_col[k] = col_lo + j * stride;
+
+					if (found < count) found++;
+				}
+			}
+		}
+
+		free_validity_mask(mask);
+	}
+
+	free(win_lat.data);
+	free(win_lon.data);
+
+	return found;
+}
+
+double pyramid_level(pyramid_search* ps, int row_lo, int row_hi, int col_lo, int col_hi, int stride, int* ret_row, int* ret_col) {
+
+	int cand_row[PYRAMID_CANDIDATES];
+	int cand_col[PYRAMID_CANDIDATES];
+	double cand_dis[PYRAMID_CANDIDATES];
+
+	if (stride == 1) {
+
+		int walk;
+		for (walk = 0; walk < MAX_PYRAMID_WALK; walk++) {
+
+			if (!pyramid_window(ps, row_lo, row_hi, col_lo, col_hi, 1, 1, cand_row, cand_col, cand_dis)) return 99999;
+
+			int on_edge =
+				(cand_row[0] - row_lo < PYRAMID_EDGE_MARGIN && row_lo > 0) ||
+				(row_hi - cand_row[0] < PYRAMID_EDGE_MARGIN && row_hi < ps->rows - 1) ||
+				(cand_col[0] - col_lo < PYRAMID_EDGE_MARGIN && col_lo > 0) ||
+				(col_hi - cand_col[0] < PYRAMID_EDGE_MARGIN && col_hi < ps->cols - 1);
+
+			if (!on_edge) break;
+
+			// Re-center the same sized window on the best pixel
+			int half_rows = (row_hi - row_lo) / 2;
+			int half_cols = (col_hi - col_lo) / 2;
+			row_lo = cand_row[0] - half_rows < 0 ? 0 : cand_row[0] - half_rows;
+			row_hi = cand_row[0] + half_rows > ps->rows - 1 ? ps->rows - 1 : cand_row[0] + half_rows;
+			col_lo = cand_col[0] - half_cols < 0 ? 0 : cand_col[0] - half_cols;
+			col_hi = cand_col[0] + half_cols > ps->cols - 1 ? ps->cols - 1 : cand_col[0] + half_cols;
+		}
+
+		*ret_row = cand_row[0];
+		*ret_col = cand_col[0];
+		return cand_dis[0];
+	}
+
+	int found = pyramid_window(ps, row_lo, row_hi, col_lo, col_hi, stride, PYRAMID_CANDIDATES, cand_row, cand_col, cand_dis);
+
+	// Windows small enough are read at full resolution, otherwise refine again
+	int next_stride = stride / PYRAMID_REFINE;
+	if ((2 * stride + 1) * (2 * stride + 1) <= PYRAMID_MAX_WINDOW || next_stride < 1) next_stride = 1;
+
+	double closest = 99999;
+	int i;
+
+	for (i = 0; i < found; i++) {
+
+		int r_lo = cand_row[i] - stride < 0 ? 0 : cand_row[i] - stride;
+		int r_hi = cand_row[i] + stride > ps->rows - 1 ? ps->rows - 1 : cand_row[i] + stride;
+		int c_lo = cand_col[i] - stride < 0 ? 0 : cand_col[i] - stride;
+		int c_hi = cand_col[i] + stride > ps->cols - 1 ? ps->cols - 1 : cand_col[i] + stride;
+
+		int row, col;
+		double distance = pyramid_level(ps, r_lo, r_hi, c_lo, c_hi, next_stride, &row, &col);
+
+		if (closest > distance) {
+			closest = distance;
+			*ret_row = row;
+			*ret_col = col;
+		}
+	}
+
+	return closest;
+}
+
+void* get_indices_from_pyramid(pyramid_search* ps, int stride, double target_lat, double target_lon) {
+
+	ps->target_lat = target_lat;
+	ps->target_lon = target_lon;
+	ps->elements_read = 0;
+
+	int closest_row = -9999;
+	int closest_col = -9999;
+
+	if (stride < 1) stride = 1;
+
+	double closest = pyramid_level(ps, 0, ps->rows - 1, 0, ps->cols - 1, stride, &closest_row, &closest_col);
+
+	if (DEBUG_PYRAMID) printf("pyramid read %lu of %lu geolocation elements\n",
+		ps->elements_read, 2 * (size_t) ps->rows * ps->cols);
+
+	int* ret_vals = malloc(sizeof(int) * 3);
+
+	ret_vals[0] = closest_row;
+	ret_vals[1] = closest_col;
+	ret_vals[2] = closest;
+
+	return (void*) ret_vals;
+}
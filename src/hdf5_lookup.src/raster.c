@@ -0,0 +1,567 @@
+/*
+ *	Program: HDF5 Lookup v0.1
+ *
+ *	Usage: This code is free to use and modify, so long
+ *		as this header remains intact, except for
+ *		"Modifications" below.
+ *
+ *	Purpose: Inverse lookup raster (-r deg), a regular lat/lon grid over
+ *		the granule footprint where every cell lists the valid pixels
+ *		falling in it. A query indexes the raster at the target and
+ *		refines over the few pixels of the surrounding cells, instead of
+ *		scanning the whole granule.
+ *
+ *		Cells are searched in rings around the target cell. A cell is
+ *		skipped when the great circle lower bound from the target to the
+ *		cell box is no closer than the best pixel so far (or the search
+ *		radius), and the search ends at the first ring with nothing left
+ *		to visit. The result is the same pixel the brute force search
+ *		returns, ties included (lowest row-major index).
+ *
+ *		An approximate search (-e km, see approx.c) also skips the cells
+ *		that could only improve on the best pixel by less than km, and
+ *		stops at the first pixel within km of the target, so the pixel
+ *		returned is at most km further than the nearest one.
+ *
+ *		Granules spanning more than 180 degrees of longitude are rastered
+ *		in [0, 360) so the dateline does not split the footprint. Cell
+ *		bounds take the shorter way around, so a target across the
+ *		dateline from the footprint still reaches it. When the cells go
+ *		all the way around (e.g. a pass over the pole) the rings wrap
+ *		too, and the search only ends once no cell further out can be
+ *		within reach, an empty ring is not enough.
+ *
+ *	Building:
+ *		Threads (-j) count their rows' pixels per cell, the counts become
+ *		offsets, then every thread places its pixels at its own offsets,
+ *		so the lists come out in row-major order whatever the thread count.
+ *
+ *	Sidecar (-c):
+ *		The raster is saved next to the granule as File.raster and reused
+ *		when its key (tables, cell size, quality flags) and the granule's
+ *		size and modification time still match.
+ *
+ *	Functions
+ *		inverse_raster*	build_inverse_raster	- raster of the valid pixels of a mask
+ *		inverse_raster*	load_inverse_raster		- raster from a sidecar file, NULL if stale
+ *		int				save_inverse_raster		- write the sidecar file
+ *		inverse_raster*	granule_raster			- sidecar raster when current, else built (and saved)
+ *		int				raster_nearest			- nearest pixel index, thread safe, optional warm start
+ *		int				raster_nearest_within	- the same within a tolerance (-e), and the error bound achieved
+ *		void*			get_indices_from_raster	- returns { row, col, distance }
+ *		void			free_inverse_raster
+ *
+ *	Modifications:
+ *		2026 10 18 - Initial Version
+ *		2026 10 18 - raster_nearest for threaded and warm started queries
+ *		2026 10 18 - Per row penalties for space/time ranking
+ *		2026 10 18 - granule_raster, the sidecar logic shared by every mode
+ *		2026 10 18 - Approximate search within a tolerance (-e)
+ *		2026 10 18 - Rings wrap around rasters covering every longitude
+ *		2026 10 18 - Sidecar written through mkstemp, a temporary name per writer
+ */
+
+#include <pthread.h>
+#include <sys/stat.h>
+
+#define DEBUG_RASTER 0
+
+#define RASTER_MAGIC "H5LKRST1"
+#define RASTER_KEY_LEN 1024
+#define MAX_RASTER_CELLS (64 * 1024 * 1024)
+
+#define EARTH_RADIUS_KM 6367.
+
+typedef struct {
+	char key[RASTER_KEY_LEN];	// tables, cell size and flags the raster was built for
+	long long file_size;		// granule the raster was built from
+	long long file_mtime;
+	int rows;					// pixel extent
+	int cols;
+	double cell;				// degrees
+	double lat0;				// south west corner of cell 0
+	double lon0;
+	int nlat;					// cells
+	int nlon;
+	int lon360;					// longitudes taken in [0, 360)
+	double max_abs_lat;			// footprint, for the longitude lower bound
+	long long pixels;
+	int* cell_start;			// nlat * nlon + 1 offsets into pixel
+	int* pixel;					// row * cols + col, row-major within each cell
+	double search_km;			// pixels further than this are not returned
+	size_t visited;				// pixels examined by queries
+} inverse_raster;
+
+typedef struct {
+	inverse_raster* ir;
+	geo_table* t_lat;
+	geo_table* t_lon;
+	validity_mask* mask;
+	int row_lo;
+	int row_hi;
+	int* counts;				// per cell, this thread's rows
+} raster_slab;
+
+double raster_lon(inverse_raster* ir, double lon) {
+	if (ir->lon360 && lon < 0) lon += 360.;
+	return lon;
+}
+
+// A target longitude in the turn nearest the raster, so a target across the dateline starts next to it
+double raster_target_lon(inverse_raster* ir, double lon) {
+	double center = ir->lon0 + ir->nlon * ir->cell / 2.;
+	lon = raster_lon(ir, lon);
+	if (lon - center > 180.) lon -= 360.;
+	if (lon - center < -180.) lon += 360.;
+	return lon;
+}
+
+// Cell of a valid pixel
+int raster_cell(inverse_raster* ir, double lat, double lon) {
+	int i = (int) floor((lat - ir->lat0) / ir->cell);
+	int j = (int) floor((raster_lon(ir, lon) - ir->lon0) / ir->cell);
+	if (i < 0) i = 0;
+	if (i > ir->nlat - 1) i = ir->nlat - 1;
+	if (j < 0) j = 0;
+	if (j > ir->nlon - 1) j = ir->nlon - 1;
+	return i * ir->nlon + j;
+}
+
+void* raster_count(void* arg) {
+
+	raster_slab* s = (raster_slab*) arg;
+
+	int row, col;
+	for (row = s->row_lo; row < s->row_hi; row++) {
+		for (col = 0; col < s->ir->cols; col++) {
+			if (!validity_test(s->mask, row, col)) continue;
+			s->counts[raster_cell(s->ir, geo_value(s->t_lat, row, col), geo_value(s->t_lon, row, col))]++;
+		}
+	}
+
+	return NULL;
+}
+
+// counts now hold this thread's next free slot per cell
+void* raster_place(void* arg) {
+
+	raster_slab* s = (raster_slab*) arg;
+
+	int row, col;
+	for (row = s->row_lo; row < s->row_hi; row++) {
+		for (col = 0; col < s->ir->cols; col++) {
+			if (!validity_test(s->mask, row, col)) continue;
+			int cell = raster_cell(s->ir, geo_value(s->t_lat, row, col), geo_value(s->t_lon, row, col));
+			s->ir->pixel[s->counts[cell]++] = row * s->ir->cols + col;
+		}
+	}
+
+	return NULL;
+}
+
+void raster_run(raster_slab* slabs, int threads, void* (*work)(void*)) {
+
+	pthread_t* workers = malloc(sizeof(pthread_t) * threads);
+
+	int t;
+	for (t = 0; t < threads; t++) pthread_create(&workers[t], NULL, work, &slabs[t]);
+	for (t = 0; t < threads; t++) pthread_join(workers[t], NULL);
+
+	free(workers);
+}
+
+inverse_raster* build_inverse_raster(geo_table* t_lat, geo_table* t_lon, validity_mask* mask, double cell, int threads) {
+
+	if (cell <= 0 || mask->valid == 0) return NULL;
+
+	inverse_raster* ir = calloc(1, sizeof(inverse_raster));
+	ir->rows = mask->rows;
+	ir->cols = mask->cols;
+	ir->cell = cell;
+
+	// Footprint of the valid pixels, in both longitude conventions
+	double lat_min = 90, lat_max = -90;
+	double lon_min = 360, lon_max = -360, lon360_min = 360, lon360_max = -360;
+
+	int row, col;
+	for (row = 0; row < ir->rows; row++) {
+		for (col = 0; col < ir->cols; col++) {
+			if (!validity_test(mask, row, col)) continue;
+
+			double lat = geo_value(t_lat, row, col);
+			double lon = geo_value(t_lon, row, col);
+			double lon360 = lon < 0 ? lon + 360. : lon;
+
+			if (lat < lat_min) lat_min = lat;
+			if (lat > lat_max) lat_max = lat;
+			if (lon < lon_min) lon_min = lon;
+			if (lon > lon_max) lon_max = lon;
+			if (lon360 < lon360_min) lon360_min = lon360;
+			if (lon360 > lon360_max) lon360_max = lon360;
+		}
+	}
+
+	if (lon_max - lon_min > 180. && lon360_max - lon360_min < lon_max - lon_min) {
+		ir->lon360 = 1;
+		lon_min = lon360_min;
+		lon_max = lon360_max;
+	}
+
+	ir->lat0 = floor(lat_min / cell) * cell;
+	ir->lon0 = floor(lon_min / cell) * cell;
+	ir->nlat = (int) floor((lat_max - ir->lat0) / cell) + 1;
+	ir->nlon = (int) floor((lon_max - ir->lon0) / cell) + 1;
+	ir->max_abs_lat = fabs(lat_min) > fabs(lat_max) ? fabs(lat_min) : fabs(lat_max);
+
+	if ((double) ir->nlat * ir->nlon > MAX_RASTER_CELLS) {
+		free(ir);
+		return NULL;
+	}
+
+	int cells = ir->nlat * ir->nlon;
+
+	if (threads < 1) threads = 1;
+	if (threads > ir->rows) threads = ir->rows;
+
+	raster_slab* slabs = malloc(sizeof(raster_slab) * threads);
+	int t;
+	for (t = 0; t < threads; t++) {
+		slabs[t].ir = ir;
+		slabs[t].t_lat = t_lat;
+		slabs[t].t_lon = t_lon;
+		slabs[t].mask = mask;
+		slabs[t].row_lo = (long long) ir->rows * t / threads;
+		slabs[t].row_hi = (long long) ir->rows * (t + 1) / threads;
+		slabs[t].counts = calloc(cells, sizeof(int));
+	}
+
+	raster_run(slabs, threads, raster_count);
+
+	// Cell offsets, each thread's part of a cell follows the threads of earlier rows
+	ir->cell_start = malloc(sizeof(int) * (cells + 1));
+	int c, offset = 0;
+	for (c = 0; c < cells; c++) {
+		ir->cell_start[c] = offset;
+		for (t = 0; t < threads; t++) {
+			int n = slabs[t].counts[c];
+			slabs[t].counts[c] = offset;
+			offset += n;
+		}
+	}
+	ir->cell_start[cells] = offset;
+	ir->pixels = offset;
+	ir->pixel = malloc(sizeof(int) * (offset > 0 ? offset : 1));
+
+	raster_run(slabs, threads, raster_place);
+
+	for (t = 0; t < threads; t++) free(slabs[t].counts);
+	free(slabs);
+
+	if (DEBUG_RASTER) printf("raster %d x %d cells of %g deg from %g %g (lon360 %d), %lld pixels\n",
+		ir->nlat, ir->nlon, cell, ir->lat0, ir->lon0, ir->lon360, ir->pixels);
+
+	return ir;
+}
+
+double raster_bound_km(inverse_raster* ir, double lat, double d_lat, double d_lon);
+
+// Lower bound (km) from the target to any point of a cell
+double raster_cell_bound(inverse_raster* ir, double lat, double lon, int i, int j) {
+
+	double cell_lat_lo = ir->lat0 + i * ir->cell;
+	double cell_lon_lo = ir->lon0 + j * ir->cell;
+
+	double d_lat = 0, d_lon = 0;
+	if (lat < cell_lat_lo) d_lat = cell_lat_lo - lat;
+	if (lat > cell_lat_lo + ir->cell) d_lat = lat - (cell_lat_lo + ir->cell);
+	if (lon < cell_lon_lo) d_lon = cell_lon_lo - lon;
+	if (lon > cell_lon_lo + ir->cell) d_lon = lon - (cell_lon_lo + ir->cell);
+
+	// Or the other way around, across the dateline
+	if (d_lon > 360. - ir->cell - d_lon) d_lon = 360. - ir->cell - d_lon;
+
+	return raster_bound_km(ir, lat, d_lat, d_lon);
+}
+
+// Lower bound (km) from the target to any point at least d_lat and d_lon degrees away
+double raster_bound_km(inverse_raster* ir, double lat, double d_lat, double d_lon) {
+
+	if (d_lat < 0) d_lat = 0;
+	if (d_lon < 0) d_lon = 0;
+	if (d_lon > 180.) d_lon = 180.;
+
+	// haversine: a >= sin^2(dlat/2) and a >= cos^2(max |lat|) sin^2(dlon/2)
+	double max_lat = fabs(lat) > ir->max_abs_lat ? fabs(lat) : ir->max_abs_lat;
+	double bound_lat = d_lat * M_PI / 180.;
+	double bound_lon = 2. * asin(cos(max_lat * M_PI / 180.) * sin(d_lon * M_PI / 360.));
+
+	return (bound_lat > bound_lon ? bound_lat : bound_lon) * EARTH_RADIUS_KM;
+}
+
+// Nearest pixel index (row * cols + col) within search_km, or -1. Only reads the raster,
+// so threads may query one raster, each with its own visited count. A valid hint pixel
+// (e.g. the match of the previous, neighbouring target) bounds the search from the start.
+// With row_penalty (km per row, < 0 excludes the row) pixels are ranked by
+// sqrt(distance^2 + penalty^2), the great circle bound of a cell still prunes.
+//
+// With tolerance_km > 0 the search is approximate: a cell is also skipped when it cannot be
+// closer than the best pixel so far by more than the tolerance, and the search ends once a
+// pixel is within the tolerance of the target. The pixel returned is then within ret_bound
+// (<= tolerance_km) of the nearest, ret_bound being the best distance less the lowest bound
+// of the cells left (0 when the search was exact).
+int raster_nearest_within(inverse_raster* ir, geo_table* t_lat, geo_table* t_lon, double target_lat, double target_lon, int hint, const double* row_penalty,
+	double tolerance_km, double* ret_distance, double* ret_bound, size_t* visited) {
+
+	double lon = raster_target_lon(ir, target_lon);
+
+	int ci = (int) floor((target_lat - ir->lat0) / ir->cell);
+	int cj = (int) floor((lon - ir->lon0) / ir->cell);
+	if (ci < 0) ci = 0;
+	if (ci > ir->nlat - 1) ci = ir->nlat - 1;
+	if (cj < 0) cj = 0;
+	if (cj > ir->nlon - 1) cj = ir->nlon - 1;
+
+	double closest = 99999;			// ranking, km
+	double closest_km = 99999;		// great circle, km
+	int closest_index = -1;
+	double skipped = 99999;			// lowest bound of the cells left by the tolerance
+	int done = 0;
+
+	// Ties with the hint still resolve to the lowest index, as they are not pruned
+	if (hint >= 0 && (row_penalty == NULL || row_penalty[hint / ir->cols] >= 0)) {
+		closest_km = gc_distance(geo_value(t_lat, hint / ir->cols, hint % ir->cols), geo_value(t_lon, hint / ir->cols, hint % ir->cols), target_lat, target_lon);
+		closest = row_penalty == NULL ? closest_km : hypot(closest_km, row_penalty[hint / ir->cols]);
+		closest_index = hint;
+	}
+
+	int max_ring = ir->nlat > ir->nlon ? ir->nlat : ir->nlon;
+
+	// Cells all the way around: columns wrap, each visited at its offset in [-(nlon - 1) / 2, nlon / 2]
+	// from cj. The last column may overlap the first by up to a cell (slack degrees).
+	int wrapped = ir->nlon * ir->cell >= 360.;
+	double slack = ir->nlon * ir->cell - 360.;
+
+	int ring;
+	for (ring = 0; ring <= max_ring && !done; ring++) {
+
+		int visited_cells = 0;
+		int i, j;
+
+		for (i = ci - ring; i <= ci + ring && !done; i++) {
+			if (i < 0 || i >= ir->nlat) continue;
+
+			// A whole row out of reach by latitude alone
+			double limit = closest < ir->search_km ? closest : ir->search_km;
+			if (raster_bound_km(ir, target_lat, (abs(i - ci) - 1) * ir->cell, 0) > limit) continue;
+
+			// Interior rows of the ring only have their two end cells
+			int step = (i == ci - ring || i == ci + ring) ? 1 : 2 * ring;
+			if (step == 0) step = 1;
+
+			for (j = cj - ring; j <= cj + ring && !done; j += step) {
+				int jj = j;
+				if (wrapped) {
+					if (j - cj > ir->nlon / 2 || cj - j > (ir->nlon - 1) / 2) continue;
+					jj = (j + ir->nlon) % ir->nlon;
+				}
+				if (jj < 0 || jj >= ir->nlon) continue;
+
+				double bound = raster_cell_bound(ir, target_lat, lon, i, jj);
+				double limit = closest < ir->search_km ? closest : ir->search_km;
+				if (bound > limit) continue;
+
+				if (tolerance_km > 0 && closest <= ir->search_km && bound > closest - tolerance_km) {
+					if (bound < skipped) skipped = bound;
+					continue;
+				}
+
+				visited_cells++;
+
+				int cell = i * ir->nlon + jj;
+				int k;
+				for (k = ir->cell_start[cell]; k < ir->cell_start[cell + 1] && !done; k++) {
+					int index = ir->pixel[k];
+					int row = index / ir->cols;
+					int col = index % ir->cols;
+
+					if (row_penalty != NULL && row_penalty[row] < 0) continue;
+
+					double distance_km = gc_distance(geo_value(t_lat, row, col), geo_value(t_lon, row, col), target_lat, target_lon);
+					double distance = row_penalty == NULL ? distance_km : hypot(distance_km, row_penalty[row]);
+
+					if (distance < closest || (distance == closest && index < closest_index)) {
+						closest = distance;
+						closest_km = distance_km;
+						closest_index = index;
+					}
+
+					// Nothing left can be closer by more than the tolerance
+					if (tolerance_km > 0 && closest <= tolerance_km && closest <= ir->search_km) {
+						skipped = 0;
+						done = 1;
+					}
+				}
+
+				*visited += k - ir->cell_start[cell];
+			}
+		}
+
+		if (!wrapped && visited_cells == 0 && ring > 0) break;
+
+		// Cells of the next rings are ring cells away in latitude or (less the overlap) in longitude
+		if (wrapped) {
+			double limit = closest < ir->search_km ? closest : ir->search_km;
+			double d = (ring - 1) * ir->cell;
+			double lat_km = raster_bound_km(ir, target_lat, d, 0);
+			double lon_km = raster_bound_km(ir, target_lat, 0, d - slack);
+			if ((lat_km < lon_km ? lat_km : lon_km) > limit) break;
+		}
+	}
+
+	*ret_distance = closest_km;
+	*ret_bound = closest > skipped ? closest - skipped : 0;
+
+	return closest_km <= ir->search_km ? closest_index : -1;
+}
+
+int raster_nearest(inverse_raster* ir, geo_table* t_lat, geo_table* t_lon, double target_lat, double target_lon, int hint, const double* row_penalty, double* ret_distance, size_t* visited) {
+	double bound;
+	return raster_nearest_within(ir, t_lat, t_lon, target_lat, target_lon, hint, row_penalty, 0, ret_distance, &bound, visited);
+}
+
+void* get_indices_from_raster(inverse_raster* ir, geo_table* t_lat, geo_table* t_lon, const double* row_penalty, double tolerance_km, double target_lat, double target_lon) {
+
+	double closest, bound;
+	int index = raster_nearest_within(ir, t_lat, t_lon, target_lat, target_lon, -1, row_penalty, tolerance_km, &closest, &bound, &ir->visited);
+
+	if (bound > stats.approx_bound_km) stats.approx_bound_km = bound;
+
+	int* ret_vals = malloc(sizeof(int) * 3);
+
+	ret_vals[0] = index >= 0 ? index / ir->cols : -9999;
+	ret_vals[1] = index >= 0 ? index % ir->cols : -9999;
+	ret_vals[2] = closest;
+
+	return (void*) ret_vals;
+}
+
+inverse_raster* load_inverse_raster(const char* file, const char* key, long long file_size, long long file_mtime) {
+
+	FILE* fp = fopen(file, "rb");
+	if (fp == NULL) return NULL;
+
+	char magic[8];
+	inverse_raster* ir = calloc(1, sizeof(inverse_raster));
+
+	int ok = fread(magic, 1, 8, fp) == 8 && memcmp(magic, RASTER_MAGIC, 8) == 0;
+	ok = ok && fread(ir, sizeof(inverse_raster), 1, fp) == 1;
+	ok = ok && strncmp(ir->key, key, RASTER_KEY_LEN) == 0 && ir->file_size == file_size && ir->file_mtime == file_mtime;
+	ok = ok && ir->nlat > 0 && ir->nlon > 0 && (double) ir->nlat * ir->nlon <= MAX_RASTER_CELLS && ir->pixels >= 0;
+
+	ir->cell_start = NULL;
+	ir->pixel = NULL;
+
+	if (ok) {
+		int cells = ir->nlat * ir->nlon;
+		ir->cell_start = malloc(sizeof(int) * (cells + 1));
+		ir->pixel = malloc(sizeof(int) * (ir->pixels > 0 ? ir->pixels : 1));
+		ok = fread(ir->cell_start, sizeof(int), cells + 1, fp) == (size_t) cells + 1 &&
+			fread(ir->pixel, sizeof(int), ir->pixels, fp) == (size_t) ir->pixels &&
+			ir->cell_start[cells] == ir->pixels;
+	}
+
+	fclose(fp);
+
+	if (!ok) {
+		free(ir->cell_start);
+		free(ir->pixel);
+		free(ir);
+		return NULL;
+	}
+
+	ir->visited = 0;
+
+	return ir;
+}
+
+// Written to a unique temporary name and renamed, readers never see a partial file
+// and writers racing on the same granule (-D workers) never share one
+int save_inverse_raster(inverse_raster* ir, const char* file) {
+
+	int length = strlen(file) + 8;
+	char* tmp = malloc(length);
+	snprintf(tmp, length, "%s.XXXXXX", file);
+
+	int fd = mkstemp(tmp);
+	if (fd < 0) {
+		free(tmp);
+		return 0;
+	}
+
+	// mkstemp creates it 0600, other readers of the granule need the sidecar too
+	fchmod(fd, 0644);
+
+	FILE* fp = fdopen(fd, "wb");
+	if (fp == NULL) {
+		close(fd);
+		remove(tmp);
+		free(tmp);
+		return 0;
+	}
+
+	int cells = ir->nlat * ir->nlon;
+	int ok = fwrite(RASTER_MAGIC, 1, 8, fp) == 8 &&
+		fwrite(ir, sizeof(inverse_raster), 1, fp) == 1 &&
+		fwrite(ir->cell_start, sizeof(int), cells + 1, fp) == (size_t) cells + 1 &&
+		fwrite(ir->pixel, sizeof(int), ir->pixels, fp) == (size_t) ir->pixels;
+
+	if (fclose(fp) != 0) ok = 0;
+
+	if (ok) ok = rename(tmp, file) == 0;
+	if (!ok) remove(tmp);
+
+	free(tmp);
+
+	return ok;
+}
+
+// From File.raster when current (cached set), else built and, with sidecar set, saved there
+inverse_raster* granule_raster(const char* path, const char* lat_table, const char* lon_table, const char* flag_spec, double cell,
+	geo_table* t_lat, geo_table* t_lon, validity_mask* mask, int threads, int sidecar, int* cached) {
+
+	char key[RASTER_KEY_LEN];
+	snprintf(key, RASTER_KEY_LEN, "%s %s %g %s", lat_table, lon_table, cell, flag_spec != NULL ? flag_spec : "");
+
+	char* sidecar_file = malloc(strlen(path) + 8);
+	sprintf(sidecar_file, "%s.raster", path);
+
+	struct stat st;
+	memset(&st, 0, sizeof(st));
+	stat(path, &st);
+
+	inverse_raster* ir = sidecar ? load_inverse_raster(sidecar_file, key, st.st_size, st.st_mtime) : NULL;
+	*cached = ir != NULL;
+
+	if (ir == NULL) {
+		ir = build_inverse_raster(t_lat, t_lon, mask, cell, threads);
+
+		if (ir != NULL) {
+			strncpy(ir->key, key, RASTER_KEY_LEN);
+			ir->file_size = st.st_size;
+			ir->file_mtime = st.st_mtime;
+
+			if (sidecar && !save_inverse_raster(ir, sidecar_file)) fprintf(stderr, "Unable to write %s\n", sidecar_file);
+		}
+	}
+
+	free(sidecar_file);
+
+	return ir;
+}
+
+void free_inverse_raster(inverse_raster* ir) {
+	if (ir == NULL) return;
+	free(ir->cell_start);
+	free(ir->pixel);
+	free(ir);
+}
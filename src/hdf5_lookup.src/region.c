@@ -0,0 +1,357 @@
+/*
+ *	Program: HDF5 Lookup v0.1
+ *
+ *	Usage: This code is free to use and modify, so long
+ *		as this header remains intact, except for
+ *		"Modifications" below.
+ *
+ *	Purpose: Region aggregation (-a region). Count, mean, standard
+ *		deviation, min and max of each variable over the valid pixels
+ *		inside a box or polygon, e.g. a city or a field site.
+ *
+ *		region is either
+ *			south,north,west,east		a lat/lon box (east > 180 crosses the dateline)
+ *			Polygon.txt					"lat lon" vertices, one per line, as for -b
+ *
+ *		Only the inverse raster (raster.c) cells overlapping the region's
+ *		bounding box are visited, and only their pixels are tested against
+ *		the region. Each variable is then read as the one hyperslab covering
+ *		the pixels inside, at the variable's own resolution, and pixels
+ *		equal to its _FillValue are left out. Values are as stored, not
+ *		scaled.
+ *
+ *		The -j threads reduce slices of the values with Welford's update,
+ *		and the slices are combined in order with Chan's pairwise formula,
+ *		so the result is stable for large counts and the same on every run.
+ *		The standard deviation is the sample one (n - 1).
+ *
+ *	Functions
+ *		int			parse_region		- box or polygon of -a
+ *		int			region_contains		- 1 if lat/lon is inside
+ *		int*		region_pixels		- sorted pixel indices inside, from the raster
+ *		int			aggregate_variable	- statistics of one variable over the pixels
+ *		void		free_region
+ *
+ *	Modifications:
+ *		2026 10 18 - Initial Version
+ */
+
+#define DEBUG_REGION 0
+
+#define REGION_RASTER_DEG 0.05		// -r default in region mode
+
+typedef struct {
+	double south;				// bounding box, west <= east, east may exceed 180
+	double north;
+	double west;
+	double east;
+	int vertices;				// 0 for a box
+	double* vertex_lat;
+	double* vertex_lon;			// unwrapped to within 180 of the first vertex
+} lookup_region;
+
+typedef struct {
+	size_t count;
+	double mean;
+	double m2;					// sum of squared differences from the mean
+	double min;
+	double max;
+} region_stats;
+
+typedef struct {
+	double* values;
+	size_t first;
+	size_t last;
+	region_stats result;
+} region_slice;
+
+int parse_region(const char* spec, lookup_region* r) {
+
+	memset(r, 0, sizeof(lookup_region));
+
+	if (sscanf(spec, "%lf,%lf,%lf,%lf", &r->south, &r->north, &r->west, &r->east) == 4) {
+		if (r->west > r->east) r->east += 360.;
+		return r->south < r->north && r->east - r->west <= 360.;
+	}
+
+	int count;
+	lookup_target* vertices = read_targets(spec, &count);
+	if (vertices == NULL || count < 3) {
+		free(vertices);
+		return 0;
+	}
+
+	r->vertices = count;
+	r->vertex_lat = malloc(sizeof(double) * count);
+	r->vertex_lon = malloc(sizeof(double) * count);
+	r->south = 90;
+	r->north = -90;
+	r->west = 1e9;
+	r->east = -1e9;
+
+	int i;
+	for (i = 0; i < count; i++) {
+		double lon = vertices[i].lon;
+		if (i > 0) {
+			while (lon - r->vertex_lon[0] > 180.) lon -= 360.;
+			while (lon - r->vertex_lon[0] < -180.) lon += 360.;
+		}
+
+		r->vertex_lat[i] = vertices[i].lat;
+		r->vertex_lon[i] = lon;
+
+		if (r->vertex_lat[i] < r->south) r->south = r->vertex_lat[i];
+		if (r->vertex_lat[i] > r->north) r->north = r->vertex_lat[i];
+		if (lon < r->west) r->west = lon;
+		if (lon > r->east) r->east = lon;
+	}
+
+	free(vertices);
+
+	return 1;
+}
+
+// lon taken in [west, west + 360)
+double region_lon(lookup_region* r, double lon) {
+	while (lon < r->west) lon += 360.;
+	while (lon >= r->west + 360.) lon -= 360.;
+	return lon;
+}
+
+int region_contains(lookup_region* r, double lat, double lon) {
+
+	lon = region_lon(r, lon);
+
+	if (lat < r->south || lat > r->north || lon > r->east) return 0;
+	if (r->vertices == 0) return 1;
+
+	// Crossings of a ray towards the north pole, on the unwrapped vertices
+	int i, j, inside = 0;
+	for (i = 0, j = r->vertices - 1; i < r->vertices; j = i++) {
+		double lon_i = r->vertex_lon[i], lon_j = r->vertex_lon[j];
+		if ((lon_i > lon) == (lon_j > lon)) continue;
+
+		double lat_cross = r->vertex_lat[j] + (lon - lon_j) * (r->vertex_lat[i] - r->vertex_lat[j]) / (lon_i - lon_j);
+		if (lat < lat_cross) inside = !inside;
+	}
+
+	return inside;
+}
+
+int compare_pixel(const void* a, const void* b) {
+	return *(const int*) a - *(const int*) b;
+}
+
+int compare_offset(const void* a, const void* b) {
+	size_t x = *(const size_t*) a, y = *(const size_t*) b;
+	return x < y ? -1 : x > y;
+}
+
+// Valid pixels inside the region, row-major. Returns NULL when there are none.
+int* region_pixels(inverse_raster* ir, geo_table* t_lat, geo_table* t_lon, lookup_region* r, int* count) {
+
+	*count = 0;
+
+	int i_lo = (int) floor((r->south - ir->lat0) / ir->cell);
+	int i_hi = (int) floor((r->north - ir->lat0) / ir->cell);
+	if (i_lo < 0) i_lo = 0;
+	if (i_hi > ir->nlat - 1) i_hi = ir->nlat - 1;
+
+	int allocated = 1024;
+	int* pixels = malloc(sizeof(int) * allocated);
+
+	int i, j, k;
+	for (i = i_lo; i <= i_hi; i++) {
+		for (j = 0; j < ir->nlon; j++) {
+
+			// Cell box against the region box, in the region's longitudes
+			double cell_west = region_lon(r, ir->lon0 + j * ir->cell);
+			double cell_east = cell_west + ir->cell;
+			if (cell_west > r->east && cell_east - 360. < r->west) continue;
+
+			int cell = i * ir->nlon + j;
+			ir->visited += ir->cell_start[cell + 1] - ir->cell_start[cell];
+
+			for (k = ir->cell_start[cell]; k < ir->cell_start[cell + 1]; k++) {
+				int index = ir->pixel[k];
+				int row = index / ir->cols, col = index % ir->cols;
+
+				if (!region_contains(r, geo_value(t_lat, row, col), geo_value(t_lon, row, col))) continue;
+
+				if (*count == allocated) {
+					allocated *= 2;
+					pixels = realloc(pixels, sizeof(int) * allocated);
+				}
+				pixels[(*count)++] = index;
+			}
+		}
+	}
+
+	if (*count == 0) {
+		free(pixels);
+		return NULL;
+	}
+
+	qsort(pixels, *count, sizeof(int), compare_pixel);
+
+	if (DEBUG_REGION) printf("region %g..%g %g..%g (%d vertices): cells %d..%d, %d pixels\n",
+		r->south, r->north, r->west, r->east, r->vertices, i_lo, i_hi, *count);
+
+	return pixels;
+}
+
+void* region_reduce(void* arg) {
+
+	region_slice* s = (region_slice*) arg;
+	region_stats* st = &s->result;
+
+	memset(st, 0, sizeof(region_stats));
+
+	size_t i;
+	for (i = s->first; i < s->last; i++) {
+		double x = s->values[i];
+
+		st->count++;
+		double delta = x - st->mean;
+		st->mean += delta / st->count;
+		st->m2 += delta * (x - st->mean);
+
+		if (st->count == 1 || x < st->min) st->min = x;
+		if (st->count == 1 || x > st->max) st->max = x;
+	}
+
+	return NULL;
+}
+
+// Chan et al. pairwise combination of two partial results into a
+void region_combine(region_stats* a, region_stats* b) {
+
+	if (b->count == 0) return;
+	if (a->count == 0) {
+		*a = *b;
+		return;
+	}
+
+	double n = a->count + b->count;
+	double delta = b->mean - a->mean;
+
+	a->mean += delta * b->count / n;
+	a->m2 += b->m2 + delta * delta * ((double) a->count * b->count / n);
+	if (b->min < a->min) a->min = b->min;
+	if (b->max > a->max) a->max = b->max;
+	a->count += b->count;
+}
+
+int aggregate_variable(const char* path, const char* table, geolocation* geo, int* pixels, int count, int threads, region_stats* result) {
+
+	memset(result, 0, sizeof(region_stats));
+
+	char *group_dat, *name_dat;
+	split_table_path(table, &group_dat, &name_dat);
+
+	hid_t* ids     = (hid_t*) get_variable_ids_by_name(path, group_dat, name_dat);
+	hid_t h5id     = ids[0];
+	hid_t grp_h5id = ids[1];
+	hid_t varid    = ids[2];
+	free(ids);
+
+	free(group_dat);
+	free(name_dat);
+
+	hid_t dataset_space = H5Dget_space(varid);
+	int ndims = H5Sget_simple_extent_ndims(dataset_space);
+	hsize_t dims[2] = { 0, 0 };
+	if (ndims == 2) H5Sget_simple_extent_dims(dataset_space, dims, NULL);
+	H5Sclose(dataset_space);
+
+	H5T_class_t data_type = get_variable_type(varid);
+
+	int ok = ndims == 2 && (data_type == H5T_INTEGER || data_type == H5T_FLOAT);
+
+	// Pixels at the variable's resolution and the box covering them
+	int* rows = malloc(sizeof(int) * count);
+	int* cols = malloc(sizeof(int) * count);
+	int row_lo = 0, row_hi = -1, col_lo = 0, col_hi = -1;
+	int i;
+
+	for (i = 0; ok && i < count; i++) {
+		rows[i] = scale_index(pixels[i] / geo->cols, geo->rows, dims[0]);
+		cols[i] = scale_index(pixels[i] % geo->cols, geo->cols, dims[1]);
+
+		if (i == 0 || rows[i] < row_lo) row_lo = rows[i];
+		if (i == 0 || rows[i] > row_hi) row_hi = rows[i];
+		if (i == 0 || cols[i] < col_lo) col_lo = cols[i];
+		if (i == 0 || cols[i] > col_hi) col_hi = cols[i];
+	}
+
+	if (ok && count > 0) {
+		int has_fill = H5Aexists(varid, "_FillValue") > 0;
+		double fill = read_scalar_attribute(varid, "_FillValue", 0.);
+
+		// One read of the box covering the pixels inside
+		hsize_t start[2] = { row_lo, col_lo };
+		hsize_t box[2] = { row_hi - row_lo + 1, col_hi - col_lo + 1 };
+		double* data = malloc(sizeof(double) * box[0] * box[1]);
+
+		if (read_variable_hyperslab(varid, H5T_NATIVE_DOUBLE, start, NULL, box, data) >= 0) {
+
+			stats.variable_reads++;
+			stats.variable_elements += box[0] * box[1];
+
+			// A coarser variable sees some of its pixels more than once
+			size_t* offsets = malloc(sizeof(size_t) * count);
+			for (i = 0; i < count; i++) offsets[i] = (size_t) (rows[i] - row_lo) * box[1] + (cols[i] - col_lo);
+			qsort(offsets, count, sizeof(size_t), compare_offset);
+
+			double* values = malloc(sizeof(double) * count);
+			size_t n = 0;
+			for (i = 0; i < count; i++) {
+				if (i > 0 && offsets[i] == offsets[i - 1]) continue;
+
+				double x = data[offsets[i]];
+				if (has_fill && x == fill) continue;
+				values[n++] = x;
+			}
+
+			free(offsets);
+
+			int slices = threads > 1 ? threads : 1;
+			if ((size_t) slices > n) slices = n > 0 ? n : 1;
+
+			region_slice* slice = malloc(sizeof(region_slice) * slices);
+			pthread_t* workers = malloc(sizeof(pthread_t) * slices);
+			int t;
+			for (t = 0; t < slices; t++) {
+				slice[t].values = values;
+				slice[t].first = n * t / slices;
+				slice[t].last = n * (t + 1) / slices;
+				pthread_create(&workers[t], NULL, region_reduce, &slice[t]);
+			}
+			for (t = 0; t < slices; t++) pthread_join(workers[t], NULL);
+
+			for (t = 0; t < slices; t++) region_combine(result, &slice[t].result);
+
+			free(workers);
+			free(slice);
+			free(values);
+		} else {
+			ok = 0;
+		}
+
+		free(data);
+	}
+
+	free(rows);
+	free(cols);
+
+	H5Dclose(varid);
+	H5Gclose(grp_h5id);
+	H5Fclose(h5id);
+
+	return ok;
+}
+
+void free_region(lookup_region* r) {
+	free(r->vertex_lat);
+	free(r->vertex_lon);
+}
@@ -0,0 +1,144 @@
+/*
+ *	Program: HDF5 Lookup v0.1
+ *
+ *	Usage: This code is free to use and modify, so long
+ *		as this header remains intact, except for
+ *		"Modifications" below.
+ *
+ *	Purpose: Time aware search (-t TimeTable:window{:km_per_unit}) with a
+ *		per scan time dataset such as /All_Data/VIIRS-DNB-GEO_All/MidTime.
+ *
+ *		Targets carry a time (third column of -b lines, or target_time
+ *		after target_lat target_lon), in the units of TimeTable (IET
+ *		microseconds for VIIRS). Before any spatial search the scans are
+ *		pruned to those within window of the target time, and the rows
+ *		of the others are skipped. Among the remaining pixels the nearest
+ *		in space and time wins:
+ *
+ *			sqrt(distance_km^2 + (km_per_unit * |scan_time - time|)^2)
+ *
+ *		km_per_unit 0 (the default) ranks by distance alone inside the
+ *		window. Scans without a time (_FillValue or negative) are never
+ *		searched. Targets without a time are searched without the window.
+ *
+ *		Each scan covers rows / scans consecutive geolocation rows.
+ *
+ *	Functions
+ *		int				parse_time_spec		- table, window and weight of -t
+ *		scan_times*		read_scan_times		- per scan times of a table
+ *		const double*	scan_penalty		- per row penalties for a target time, NULL without one
+ *		void			free_scan_times
+ *
+ *	Modifications:
+ *		2026 10 18 - Initial Version
+ */
+
+#define DEBUG_SCANTIME 0
+
+typedef struct {
+	double* time;				// per scan, NAN when missing
+	int scans;
+	int rows;					// geolocation rows
+	int rows_per_scan;
+	double window;				// time units
+	double km_per_unit;
+	double* row_penalty;		// rows, for the current target
+} scan_times;
+
+// Fills table (new string), window and km_per_unit from TimeTable:window{:km_per_unit}
+int parse_time_spec(const char* spec, char** table, double* window, double* km_per_unit) {
+
+	const char* sep = strchr(spec, ':');
+	if (sep == NULL || sep == spec) return 0;
+
+	*km_per_unit = 0;
+
+	char* end;
+	*window = strtod(sep + 1, &end);
+	if (end == sep + 1 || *window < 0) return 0;
+	if (*end == ':') *km_per_unit = strtod(end + 1, &end);
+	if (*end != 0 || *km_per_unit < 0) return 0;
+
+	*table = strndup(spec, sep - spec);
+
+	return 1;
+}
+
+scan_times* read_scan_times(const char* path, const char* group, const char* name, int rows) {
+
+	hid_t* ids     = (hid_t*) get_variable_ids_by_name(path, group, name);
+	hid_t h5id     = ids[0];
+	hid_t grp_h5id = ids[1];
+	hid_t varid    = ids[2];
+	free(ids);
+
+	hid_t dataset_space = H5Dget_space(varid);
+	int ndims = H5Sget_simple_extent_ndims(dataset_space);
+	hsize_t count[1] = { 0 };
+	if (ndims == 1) H5Sget_simple_extent_dims(dataset_space, count, NULL);
+	H5Sclose(dataset_space);
+
+	int scans = count[0];
+	double* time = NULL;
+
+	if (scans > 0 && rows % scans == 0) {
+		hsize_t start[1] = { 0 };
+		time = malloc(sizeof(double) * scans);
+		if (read_variable_hyperslab(varid, H5T_NATIVE_DOUBLE, start, NULL, count, time) < 0) {
+			free(time);
+			time = NULL;
+		}
+	}
+
+	int has_fill = H5Aexists(varid, "_FillValue") > 0;
+	double fill = read_scalar_attribute(varid, "_FillValue", 0.);
+
+	H5Dclose(varid);
+	H5Gclose(grp_h5id);
+	H5Fclose(h5id);
+
+	if (time == NULL) return NULL;
+
+	int s;
+	for (s = 0; s < scans; s++) {
+		if ((has_fill && time[s] == fill) || time[s] < 0) time[s] = NAN;
+	}
+
+	scan_times* st = calloc(1, sizeof(scan_times));
+	st->time = time;
+	st->scans = scans;
+	st->rows = rows;
+	st->rows_per_scan = rows / scans;
+	st->row_penalty = malloc(sizeof(double) * rows);
+
+	if (DEBUG_SCANTIME) printf("scan times %s: %d scans of %d rows, %f .. %f\n", name, scans, st->rows_per_scan, time[0], time[scans - 1]);
+
+	return st;
+}
+
+const double* scan_penalty(scan_times* st, double time) {
+
+	if (isnan(time)) return NULL;
+
+	int s, r;
+	for (s = 0; s < st->scans; s++) {
+		double dt = fabs(st->time[s] - time);
+
+		// NAN scan times fail the window test too
+		double penalty = dt <= st->window ? st->km_per_unit * dt : -1;
+
+		if (penalty >= 0) stats.scans_searched++;
+		else stats.scans_pruned++;
+
+		for (r = s * st->rows_per_scan; r < (s + 1) * st->rows_per_scan; r++) st->row_penalty[r] = penalty;
+	}
+
+	return st->row_penalty;
+}
+
+void free_scan_times(scan_times* st) {
+	if (st == NULL) return;
+	free(st->time);
+	free(st->row_penalty);
+	free(st);
+}
@@ -0,0 +1,102 @@
+/*
+ *	Program: HDF5 Lookup v0.1
+ *
+ *	Usage: This code is free to use and modify, so long
+ *		as this header remains intact, except for
+ *		"Modifications" below.
+ *
+ *	Purpose: Counters for the -s statistics, written to standard error
+ *		so they never mix with the lookup results on standard out.
+ *
+ *	Functions
+ *		void		print_lookup_stats		- write the counters
+ *
+ *	Modifications:
+ *		2026 10 18 - Initial Version
+ */
+
+typedef struct {
+	size_t targets;					// targets searched
+	size_t matches;					// targets within MAX_GOOD_DIS_KM
+	size_t file_images;				// files read into memory (-m)
+	size_t geolocation_elements;	// lat + lon elements read for the search
+	size_t geolocation_direct;		// lat/lon tables loaded by parallel direct chunk reads
+	size_t geolocation_mapped;		// lat/lon tables mapped from the file, not read
+	size_t geolocation_valid;		// pixels set in the validity mask
+	size_t geolocation_unpacked_bytes;	// lat/lon tables packed (-z), in their stored type
+	size_t geolocation_packed_bytes;	// the same tables packed
+	size_t flag_passed;				// pixels passing the quality flags (-q)
+	size_t raster_cells;			// inverse raster cells (-r)
+	size_t raster_cached;			// inverse rasters read from their sidecar files (-c)
+	size_t raster_visited;			// pixels examined by raster queries
+	double approx_bound_km;			// largest error bound achieved by -e searches
+	size_t approx_verified;			// -e results checked against the brute force search
+	size_t approx_violations;		// of those, further than the tolerance from the nearest
+	double approx_error_km;			// largest distance beyond the nearest found by the check
+	size_t grid_cells;				// output grid cells (-g)
+	size_t grid_filled;				// grid cells with a pixel within MAX_GOOD_DIS_KM
+	size_t region_pixels;			// valid pixels inside the -a region
+	size_t collocate_pixels;		// valid source pixels (-C)
+	size_t collocate_matched;		// source pixels with a target pixel within MAX_GOOD_DIS_KM
+	size_t scans_searched;			// scans inside a target's time window (-t), over all targets
+	size_t scans_pruned;			// scans outside it, never searched
+	size_t virtual_granules_loaded;	// granules of a -G swath read whole
+	size_t virtual_band_rows;		// boundary rows read from their neighbours
+	size_t virtual_time_pruned;		// granule and target pairs outside the -t window
+	size_t readahead_bytes;			// granule lat/lon bytes advised into the page cache (-R)
+	size_t readahead_released;		// and advised out again once searched
+	size_t follow_polls;			// extent refreshes of a file being written (-F)
+	size_t follow_rows;				// rows read as they were appended
+	size_t watch_published;			// granules indexed and added to the -D catalog
+	size_t memo_hits;				// targets answered from the -M cache
+	size_t memo_misses;				// targets not in it, searched
+	size_t memo_evicted;			// cached lines replaced by newer ones
+	size_t variable_reads;			// H5Dread calls for variables
+	size_t variable_chunks;			// chunks read (each decompressed once) for variables
+	size_t variable_elements;		// variable elements returned
+	size_t chunk_cache_bytes;		// largest chunk cache set on a variable
+} lookup_stats;
+
+lookup_stats stats;
+
+void print_lookup_stats(FILE* fp) {
+	fprintf(fp, "targets:              %lu\n", stats.targets);
+	fprintf(fp, "matches:              %lu\n", stats.matches);
+	fprintf(fp, "file images:          %lu\n", stats.file_images);
+	fprintf(fp, "geolocation elements: %lu\n", stats.geolocation_elements);
+	fprintf(fp, "geolocation direct:   %lu\n", stats.geolocation_direct);
+	fprintf(fp, "geolocation mapped:   %lu\n", stats.geolocation_mapped);
+	fprintf(fp, "geolocation valid:    %lu\n", stats.geolocation_valid);
+	fprintf(fp, "geolocation unpacked: %lu\n", stats.geolocation_unpacked_bytes);
+	fprintf(fp, "geolocation packed:   %lu\n", stats.geolocation_packed_bytes);
+	fprintf(fp, "flag passed:          %lu\n", stats.flag_passed);
+	fprintf(fp, "raster cells:         %lu\n", stats.raster_cells);
+	fprintf(fp, "raster cached:        %lu\n", stats.raster_cached);
+	fprintf(fp, "raster visited:       %lu\n", stats.raster_visited);
+	fprintf(fp, "approx bound km:      %f\n", stats.approx_bound_km);
+	fprintf(fp, "approx verified:      %lu\n", stats.approx_verified);
+	fprintf(fp, "approx violations:    %lu\n", stats.approx_violations);
+	fprintf(fp, "approx error km:      %f\n", stats.approx_error_km);
+	fprintf(fp, "grid cells:           %lu\n", stats.grid_cells);
+	fprintf(fp, "grid filled:          %lu\n", stats.grid_filled);
+	fprintf(fp, "region pixels:        %lu\n", stats.region_pixels);
+	fprintf(fp, "collocate pixels:     %lu\n", stats.collocate_pixels);
+	fprintf(fp, "collocate matched:    %lu\n", stats.collocate_matched);
+	fprintf(fp, "scans searched:       %lu\n", stats.scans_searched);
+	fprintf(fp, "scans pruned:         %lu\n", stats.scans_pruned);
+	fprintf(fp, "virtual granules:     %lu\n", stats.virtual_granules_loaded);
+	fprintf(fp, "virtual band rows:    %lu\n", stats.virtual_band_rows);
+	fprintf(fp, "virtual time pruned:  %lu\n", stats.virtual_time_pruned);
+	fprintf(fp, "readahead bytes:      %lu\n", stats.readahead_bytes);
+	fprintf(fp, "readahead released:   %lu\n", stats.readahead_released);
+	fprintf(fp, "follow polls:         %lu\n", stats.follow_polls);
+	fprintf(fp, "follow rows:          %lu\n", stats.follow_rows);
+	fprintf(fp, "watch published:      %lu\n", stats.watch_published);
+	fprintf(fp, "memo hits:            %lu\n", stats.memo_hits);
+	fprintf(fp, "memo misses:          %lu\n", stats.memo_misses);
+	fprintf(fp, "memo evicted:         %lu\n", stats.memo_evicted);
+	fprintf(fp, "variable reads:       %lu\n", stats.variable_reads);
+	fprintf(fp, "variable chunks:      %lu\n", stats.variable_chunks);
+	fprintf(fp, "variable elements:    %lu\n", stats.variable_elements);
+	fprintf(fp, "chunk cache bytes:    %lu\n", stats.chunk_cache_bytes);
+}
@@ -0,0 +1,250 @@
+/*
+ *	Program: HDF5 Lookup v0.1
+ *
+ *	Usage: This code is free to use and modify, so long
+ *		as this header remains intact, except for
+ *		"Modifications" below.
+ *
+ *	Purpose: Search reduced resolution (tie-point) geolocation
+ *		grids without expanding them to full resolution.
+ *
+ *		The coarse tie-point grid is searched first, then
+ *		geolocation is interpolated only in the neighborhood
+ *		of the best tie-point to find the full resolution pixel.
+ *
+ *	Tie-point layout (-T row_step,col_step{,rows_per_scan}):
+ *		row_step		full resolution rows between tie rows
+ *		col_step		full resolution columns between tie columns
+ *		rows_per_scan	detector rows in one scan (0 or omitted = no scans)
+ *
+ *		Tie rows restart at the first detector of every scan and the
+ *		last tie of a scan (or granule) is clamped to its last row, e.g.
+ *		VIIRS moderate bands are "15,8,16" (2 tie rows per 16 row scan).
+ *		Interpolation never crosses a scan boundary; pixels past the
+ *		last tie of a scan are extrapolated from within the same scan,
+ *		which keeps the bow-tie overlap between scans intact. The full
+ *		resolution rows have to be a whole number of scans.
+ *
+ *	Functions
+ *		int			parse_tiepoint_spec			- fill row/col step and scan size from -T
+ *		int			set_tiepoint_dims			- set full and tie extents, verify layout
+ *		int			tiepoint_interpolate		- lat/lon of one full resolution pixel
+ *		void*		get_indices_from_tiepoints	- returns { row, col, distance } at full resolution
+ *
+ *	Modifications:
+ *		2026 10 18 - Initial Version
+ *		2026 10 18 - Tie grids in their stored type (geotable.c)
+ *		2026 10 18 - Tie-point validity from the validity mask
+ *		2026 10 18 - Quality flag mask (-q) at full resolution
+ */
+
+#define DEBUG_TIEPOINT 0
+
+// Iterations allowed to walk the window when the best pixel is on its edge
+#define MAX_TIEPOINT_WALK 8
+
+// Pixels from the window edge that still count as on it, flagged (-q) pixels can hide the edge itself
+#define TIEPOINT_EDGE_MARGIN 4
+
+typedef struct {
+	int rows;					// full resolution extent
+	int cols;
+	int tie_rows;				// tie-point grid extent
+	int tie_cols;
+	int row_step;
+	int col_step;
+	int rows_per_scan;			// full rows in a scan (whole granule if no scans)
+	int tie_rows_per_scan;		// tie rows in a scan
+	geo_table* tie_lat;
+	geo_table* tie_lon;
+	validity_mask* tie_mask;
+	validity_mask* flag_mask;	// full resolution quality flags (-q), or NULL
+} tiepoint_grid;
+
+int parse_tiepoint_spec(const char* spec, tiepoint_grid* tp) {
+
+	memset(tp, 0, sizeof(tiepoint_grid));
+
+	int n = sscanf(spec, "%d,%d,%d", &tp->row_step, &tp->col_step, &tp->rows_per_scan);
+
+	if (n < 2 || tp->row_step < 1 || tp->col_step < 1 || tp->rows_per_scan < 0) return 0;
+
+	return 1;
+}
+
+int set_tiepoint_dims(tiepoint_grid* tp, int rows, int cols, int tie_rows, int tie_cols) {
+
+	tp->rows = rows;
+	tp->cols = cols;
+	tp->tie_rows = tie_rows;
+	tp->tie_cols = tie_cols;
+
+	if (tp->rows_per_scan == 0 || tp->rows_per_scan > rows) tp->rows_per_scan = rows;
+
+	tp->tie_rows_per_scan = (tp->rows_per_scan - 1 + tp->row_step - 1) / tp->row_step + 1;
+
+	int scans = rows / tp->rows_per_scan;
+	int expected_cols = (cols - 1 + tp->col_step - 1) / tp->col_step + 1;
+
+	if (DEBUG_TIEPOINT) printf("tie grid %d x %d, full %d x %d, %d scans of %d rows (%d tie rows)\n",
+		tie_rows, tie_cols, rows, cols, scans, tp->rows_per_scan, tp->tie_rows_per_scan);
+
+	// A partial last scan has no tie rows of its own
+	if (tp->tie_rows_per_scan < 2 || tie_cols < 2) return 0;
+	if (rows % tp->rows_per_scan != 0) return 0;
+	if (scans * tp->tie_rows_per_scan != tie_rows) return 0;
+	if (expected_cols != tie_cols) return 0;
+
+	return 1;
+}
+
+// Full resolution row of a tie row (clamped to the last row of its scan)
+int tiepoint_row_position(tiepoint_grid* tp, int tie_row) {
+	int scan = tie_row / tp->tie_rows_per_scan;
+	int offset = (tie_row % tp->tie_rows_per_scan) * tp->row_step;
+	if (offset > tp->rows_per_scan - 1) offset = tp->rows_per_scan - 1;
+	return scan * tp->rows_per_scan + offset;
+}
+
+// Full resolution column of a tie column (clamped to the last column)
+int tiepoint_col_position(tiepoint_grid* tp, int tie_col) {
+	int col = tie_col * tp->col_step;
+	if (col > tp->cols - 1) col = tp->cols - 1;
+	return col;
+}
+
+void latlon_to_xyz(double lat, double lon, double* v) {
+	double lat_r = lat * M_PI / 180.;
+	double lon_r = lon * M_PI / 180.;
+	v[0] = cos(lat_r) * cos(lon_r);
+	v[1] = cos(lat_r) * sin(lon_r);
+	v[2] = sin(lat_r);
+}
+
+int tiepoint_interpolate(tiepoint_grid* tp, int row, int col, double* lat, double* lon) {
+
+	// Bracketing tie rows, both inside the scan holding this row
+	int scan = row / tp->rows_per_scan;
+	int j0 = (row % tp->rows_per_scan) / tp->row_step;
+	if (j0 > tp->tie_rows_per_scan - 2) j0 = tp->tie_rows_per_scan - 2;
+	int t_r0 = scan * tp->tie_rows_per_scan + j0;
+	int t_r1 = t_r0 + 1;
+
+	int t_c0 = col / tp->col_step;
+	if (t_c0 > tp->tie_cols - 2) t_c0 = tp->tie_cols - 2;
+	int t_c1 = t_c0 + 1;
+
+	int p_r0 = tiepoint_row_position(tp, t_r0);
+	int p_r1 = tiepoint_row_position(tp, t_r1);
+	int p_c0 = tiepoint_col_position(tp, t_c0);
+	int p_c1 = tiepoint_col_position(tp, t_c1);
+
+	double u = (double) (row - p_r0) / (double) (p_r1 - p_r0);
+	double w = (double) (col - p_c0) / (double) (p_c1 - p_c0);
+
+	int corner_r[4] = { t_r0, t_r0, t_r1, t_r1 };
+	int corner_c[4] = { t_c0, t_c1, t_c0, t_c1 };
+	double weight[4] = { (1. - u) * (1. - w), (1. - u) * w, u * (1. - w), u * w };
+
+	// Blend unit vectors so the dateline and poles need no special case
+	double v[3] = { 0., 0., 0. };
+	int i;
+	for (i = 0; i < 4; i++) {
+		if (!validity_test(tp->tie_mask, corner_r[i], corner_c[i])) return 0;
+
+		double c_lat = geo_value(tp->tie_lat, corner_r[i], corner_c[i]);
+		double c_lon = geo_value(tp->tie_lon, corner_r[i], corner_c[i]);
+
+		double c_v[3];
+		latlon_to_xyz(c_lat, c_lon, c_v);
+		v[0] += weight[i] * c_v[0];
+		v[1] += weight[i] * c_v[1];
+		v[2] += weight[i] * c_v[2];
+	}
+
+	double norm = sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+	if (norm == 0.) return 0;
+
+	*lat = asin(v[2] / norm) * 180. / M_PI;
+	*lon = atan2(v[1], v[0]) * 180. / M_PI;
+
+	return 1;
+}
+
+void* get_indices_from_tiepoints(tiepoint_grid* tp, double target_lat, double target_lon) {
+
+	// Coarse pass over the tie-point grid itself
+	int* tie_indices = (int*) get_indices_from_geo_tables(tp->tie_lat, tp->tie_lon, tp->tie_mask, target_lat, target_lon);
+	int tie_row = tie_indices[0];
+	int tie_col = tie_indices[1];
+	free(tie_indices);
+
+	int* ret_vals = malloc(sizeof(int) * 3);
+	ret_vals[0] = -9999;
+	ret_vals[1] = -9999;
+	ret_vals[2] = 99999;
+
+	if (tie_row < 0 || tie_col < 0) return (void*) ret_vals;
+
+	// Window spans the neighboring tie rows (including into the adjacent scans) and columns
+	int row_lo = tiepoint_row_position(tp, tie_row > 0 ? tie_row - 1 : 0);
+	int row_hi = tiepoint_row_position(tp, tie_row < tp->tie_rows - 1 ? tie_row + 1 : tp->tie_rows - 1);
+	int col_lo = tiepoint_col_position(tp, tie_col > 0 ? tie_col - 1 : 0);
+	int col_hi = tiepoint_col_position(tp, tie_col < tp->tie_cols - 1 ? tie_col + 1 : tp->tie_cols - 1);
+
+	int half_rows = (row_hi - row_lo) / 2 + 1;
+	int half_cols = (col_hi - col_lo) / 2 + 1;
+
+	double closest = 99999;
+	int closest_row = -9999;
+	int closest_col = -9999;
+
+	int walk;
+	for (walk = 0; walk < MAX_TIEPOINT_WALK; walk++) {
+
+		if (DEBUG_TIEPOINT) printf("window rows %d-%d cols %d-%d\n", row_lo, row_hi, col_lo, col_hi);
+
+		int row, col;
+		for (row = row_lo; row <= row_hi; row++) {
+			for (col = col_lo; col <= col_hi; col++) {
+
+				double lat, lon;
+
+				if (tp->flag_mask != NULL && !validity_test(tp->flag_mask, row, col)) continue;
+
+				if (tiepoint_interpolate(tp, row, col, &lat, &lon)) {
+
+					double distance = gc_distance(lat, lon, target_lat, target_lon);
+
+					if (closest > distance) {
+						closest_row = row;
+						closest_col = col;
+						closest = distance;
+					}
+				}
+			}
+		}
+
+		if (closest_row < 0) break;
+
+		// Stop once the best pixel is interior (or on the granule edge)
+		int on_edge =
+			(closest_row - row_lo < TIEPOINT_EDGE_MARGIN && row_lo > 0) ||
+			(row_hi - closest_row < TIEPOINT_EDGE_MARGIN && row_hi < tp->rows - 1) ||
+			(closest_col - col_lo < TIEPOINT_EDGE_MARGIN && col_lo > 0) ||
+			(col_hi - closest_col < TIEPOINT_EDGE_MARGIN && col_hi < tp->cols - 1);
+
+		if (!on_edge) break;
+
+		row_lo = closest_row - half_rows < 0 ? 0 : closest_row - half_rows;
+		row_hi = closest_row + half_rows > tp->rows - 1 ? tp->rows - 1 : closest_row + half_rows;
+		col_lo = closest_col - half_cols < 0 ? 0 : closest_col - half_cols;
+		col_hi = closest_col + half_cols > tp->cols - 1 ? tp->cols - 1 : closest_col + half_cols;
+	}
+
+	ret_vals[0] = closest_row;
+	ret_vals[1] = closest_col;
+	ret_vals[2] = closest;
+
+	return (void*) ret_vals;
+}
@@ -0,0 +1,164 @@
+/*
+ *	Program: HDF5 Lookup v0.1
+ *
+ *	Usage: This code is free to use and modify, so long
+ *		as this header remains intact, except for
+ *		"Modifications" below.
+ *
+ *	Purpose: Packed validity bitmap of a lat/lon pair, built once at load
+ *		time so the search kernels carry no fill-value branches.
+ *
+ *		A pixel is valid when neither lat nor lon equals its _FillValue
+ *		attribute, both are above the -9999 fill range of the original
+ *		search, and lat is in [-90, 90] and lon in [-180, 360]. Swath edges
+ *		and VIIRS bow-tie deletion zones are runs of invalid pixels, so
+ *		most 64 pixel words are either all valid or all invalid.
+ *
+ *		Bits are stored per row, bit b of word w is column w * 64 + b,
+ *		and bits past the last column are always 0.
+ *
+ *	Quality flags (-q dataset:mask:value):
+ *		A pixel passes when (flag & mask) == value, e.g.
+ *		-q /All_Data/VIIRS-DNB-SDR_All/QF1_VIIRSDNBSDR:0x03:0
+ *		keeps only pixels with both low bits clear. mask and value take
+ *		decimal, 0x hex or 0 octal. The flags are evaluated once into a
+ *		mask at the search resolution and every search mode tests it.
+ *
+ *	Functions
+ *		validity_mask*	build_validity_mask		- mask of a loaded lat/lon pair
+ *		int				parse_flag_spec			- dataset, mask and value of -q
+ *		validity_mask*	build_flag_mask			- mask of a quality flag condition
+ *		void			and_validity_mask		- clear the pixels of one mask failing another
+ *		int				validity_test			- 1 if row/col is valid
+ *		void			free_validity_mask
+ *
+ *	Modifications:
+ *		2026 10 18 - Initial Version
+ *		2026 10 18 - Quality flag masks (-q)
+ */
+
+#include <stdint.h>
+
+#define DEBUG_VALIDITY 0
+
+#define VALIDITY_FULL_WORD (~(uint64_t) 0)
+
+typedef struct {
+	uint64_t* words;
+	int rows;
+	int cols;
+	int words_per_row;
+	size_t valid;				// pixels set
+} validity_mask;
+
+validity_mask* build_validity_mask(geo_table* t_lat, geo_table* t_lon) {
+
+	validity_mask* mask = malloc(sizeof(validity_mask));
+	mask->rows = t_lat->rows;
+	mask->cols = t_lat->cols;
+	mask->words_per_row = (mask->cols + 63) / 64;
+	mask->words = calloc((size_t) mask->rows * mask->words_per_row, sizeof(uint64_t));
+	mask->valid = 0;
+
+	int row, col;
+	for (row = 0; row < mask->rows; row++) {
+		uint64_t* words = &mask->words[(size_t) row * mask->words_per_row];
+
+		for (col = 0; col < mask->cols; col++) {
+			double lat = geo_value(t_lat, row, col);
+			double lon = geo_value(t_lon, row, col);
+
+			if (lat < -90. || lat > 90. || lon < -180. || lon > 360.) continue;
+
+			words[col / 64] |= (uint64_t) 1 << (col % 64);
+			mask->valid++;
+		}
+	}
+
+	if (DEBUG_VALIDITY) printf("validity mask %d x %d: %lu valid\n", mask->rows, mask->cols, (unsigned long) mask->valid);
+
+	return mask;
+}
+
+// Fills dataset/bits/value from dataset:mask:value, dataset is a new string
+int parse_flag_spec(const char* spec, char** dataset, unsigned long long* bits, unsigned long long* value) {
+
+	const char* value_sep = strrchr(spec, ':');
+	if (value_sep == NULL || value_sep == spec) return 0;
+
+	const char* bits_sep = value_sep - 1;
+	while (bits_sep > spec && *bits_sep != ':') bits_sep--;
+	if (bits_sep == spec) return 0;
+
+	char* end;
+	*bits = strtoull(bits_sep + 1, &end, 0);
+	if (end != value_sep) return 0;
+	*value = strtoull(value_sep + 1, &end, 0);
+	if (*end != 0) return 0;
+
+	long dataset_len = bits_sep - spec;
+	*dataset = malloc(dataset_len + 1);
+	strncpy(*dataset, spec, dataset_len);
+	(*dataset)[dataset_len] = 0;
+
+	return 1;
+}
+
+validity_mask* build_flag_mask(const char* path, const char* group, const char* name, unsigned long long bits, unsigned long long value) {
+
+	size_t* dims = (size_t*) get_variable_dims_by_name(path, group, name);
+	hsize_t start[2] = { 0, 0 };
+	hsize_t count[2] = { dims[0], dims[1] };
+	free(dims);
+
+	if (count[0] == 0 || count[1] == 0) return NULL;
+
+	unsigned long long** flags = get_variable_hyperslab_by_name_dimalloc2(path, group, name, H5T_NATIVE_ULLONG, start, NULL, count);
+	if (flags == NULL) return NULL;
+
+	validity_mask* mask = malloc(sizeof(validity_mask));
+	mask->rows = count[0];
+	mask->cols = count[1];
+	mask->words_per_row = (mask->cols + 63) / 64;
+	mask->words = calloc((size_t) mask->rows * mask->words_per_row, sizeof(uint64_t));
+	mask->valid = 0;
+
+	int row, col;
+	for (row = 0; row < mask->rows; row++) {
+		uint64_t* words = &mask->words[(size_t) row * mask->words_per_row];
+
+		for (col = 0; col < mask->cols; col++) {
+			if ((flags[row][col] & bits) != value) continue;
+
+			words[col / 64] |= (uint64_t) 1 << (col % 64);
+			mask->valid++;
+		}
+	}
+
+	free(flags);
+
+	if (DEBUG_VALIDITY) printf("flag mask %s (& 0x%llx == 0x%llx): %lu pass\n", name, bits, value, (unsigned long) mask->valid);
+
+	return mask;
+}
+
+void and_validity_mask(validity_mask* mask, validity_mask* other) {
+
+	size_t i, words = (size_t) mask->rows * mask->words_per_row;
+
+	mask->valid = 0;
+	for (i = 0; i < words; i++) {
+		mask->words[i] &= other->words[i];
+		mask->valid += __builtin_popcountll(mask->words[i]);
+	}
+}
+
+int validity_test(validity_mask* mask, int row, int col) {
+	return (mask->words[(size_t) row * mask->words_per_row + col / 64] >> (col % 64)) & 1;
+}
+
+void free_validity_mask(validity_mask* mask) {
+	if (mask == NULL) return;
+	free(mask->words);
+	free(mask);
+}
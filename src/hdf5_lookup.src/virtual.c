@@ -0,0 +1,692 @@
+/*
+ *	Program: HDF5 Lookup v0.1
+ *
+ *	Usage: This code is free to use and modify, so long
+ *		as this header remains intact, except for
+ *		"Modifications" below.
+ *
+ *	Purpose: Virtual swath (-G), an ordered sequence of granules, e.g.
+ *		consecutive 85 second VIIRS granules, searched as one swath.
+ *		File is then a text file naming the granules in orbit order, one
+ *		per line (lines starting with '#' are comments), optionally
+ *		preceded by the granule's bounds, as in a -D catalog (watch.c):
+ *
+ *			{south north west east} path
+ *
+ *		The path is the rest of the line, so it may hold spaces.
+ *
+ *		Geolocation is loaded incrementally:
+ *
+ *		1. A footprint of every granule, lat/lon read every
+ *		   VIRTUAL_FOOTPRINT_STRIDE rows and columns, gives each target a
+ *		   home granule (the one with the nearest footprint sample).
+ *		   Granules listed with bounds are only sampled for the targets
+ *		   within max_km of them, and not read at all without any.
+ *		2. Granules are taken in order, only those that are home to some
+ *		   target are read whole, and their targets searched (brute force,
+ *		   or -r raster, from the File.raster sidecar with -c). One granule
+ *		   is held at a time.
+ *		3. A target matched within VIRTUAL_EDGE_ROWS of the first (last)
+ *		   row may be closer to the granule before (after). Only that many
+ *		   boundary rows of the neighbour are read, once per granule, and
+ *		   searched. The nearer of the two matches wins, ties stay home.
+ *
+ *		Variables are read per granule for the targets located in it,
+ *		once the targets of a home granule are final.
+ *
+ *		With -t (scantime.c) every granule's TimeTable is read with its
+ *		footprint, giving the granule a time range (first and last scan
+ *		time). A granule is only sampled for, home to, or a neighbour of
+ *		the targets whose time window meets that range, and inside it
+ *		the scans out of the window are pruned and the rest ranked by
+ *		space and time, as for a single File. Granules whose TimeTable
+ *		cannot be read are skipped.
+ *
+ *		With -A depth the reads go to an I/O thread (pipeline.c): the
+ *		geolocation of up to depth home granules is read ahead, and the
+ *		variables of each home granule's targets behind, while the
+ *		current granule is searched. Boundary rows are read in turn with
+ *		the thread.
+ *
+ *		With -R N the kernel is asked to read the LatTable/LonTable chunks
+ *		of the next N granules of each pass into the page cache
+ *		(POSIX_FADV_WILLNEED, hdf5_advise.c) while the current one is
+ *		searched, and to drop them (POSIX_FADV_DONTNEED) once no search
+ *		needs them: granules home to no target after the footprints,
+ *		home granules once the next one is searched (its boundary rows
+ *		are read until then).
+ *
+ *	Functions
+ *		int				parse_granule_line		- bounds and path of a list line, 0 for comments
+ *		granule_list*	read_granule_list		- granule paths of a -G list file
+ *		void			set_granule_times		- -t TimeTable, window and weight searched in each granule
+ *		int				granule_in_time			- 1 when a target time is within the window of a granule's range
+ *		void			locate_virtual_swath	- nearest pixel of every target over the granules, within max_km, and its values
+ *		H5T_class_t		extract_virtual_variable - values of one variable, read from each target's granule
+ *		void			free_granule_list
+ *
+ *	Modifications:
+ *		2026 10 18 - Initial Version
+ *		2026 10 18 - Granule bounds from the list, -c raster sidecars
+ *		2026 10 18 - Variables read per home granule, -A asynchronous reads
+ *		2026 10 18 - -R page cache read-ahead and release of granule geolocation
+ *		2026 10 18 - -t granules pruned by their time range
+ */
+
+#include <ctype.h>
+
+#define DEBUG_VIRTUAL 0
+
+#define VIRTUAL_FOOTPRINT_STRIDE 16
+#define VIRTUAL_EDGE_ROWS 32
+#define GRANULE_LINE_LEN 4096
+
+typedef struct {
+	char** paths;
+	int count;
+	int* rows;					// geolocation extent of each granule
+	int* cols;
+	double* bounds;				// south north west east per granule, NAN when not listed
+	char* group_time;			// -t TimeTable, NULL without
+	char* name_time;
+	double time_window;
+	double time_km_per_unit;
+	scan_times** times;			// per granule, read with the footprints (-t)
+	double* time_range;			// first and last scan time per granule, NAN when none (-t)
+} granule_list;
+
+// Boundary band of a neighbour, rows [row0, row0 + lat->rows)
+typedef struct {
+	int granule;				// -1 when not loaded
+	int row0;
+	geo_table* lat;
+	geo_table* lon;
+	validity_mask* mask;
+} granule_band;
+
+// Whole geolocation of a home granule, an IO_AHEAD job
+typedef struct {
+	granule_list* gl;
+	int granule;
+	const char* group_lat;
+	const char* name_lat;
+	const char* group_lon;
+	const char* name_lon;
+	int threads;
+	geo_table* lat;
+	geo_table* lon;
+	volatile int done;
+} granule_read;
+
+// Variables of a home granule's targets, an IO_BEHIND job
+typedef struct {
+	granule_list* gl;
+	char** variables;
+	int variable_count;
+	lookup_target* subset;		// copy, found only for the home granule's targets
+	int count;
+	lookup_value* values;		// variable_count * count
+	H5T_class_t* data_types;
+	volatile int done;
+} variable_read;
+
+// path points into line, bounds are NAN when not listed
+int parse_granule_line(char* line, char** path, double* bounds) {
+
+	char* end = line + strlen(line);
+	while (end > line && isspace((unsigned char) end[-1])) end--;
+	*end = 0;
+
+	char* start = line;
+	while (isspace((unsigned char) *start)) start++;
+	if (*start == 0 || *start == '#') return 0;
+
+	int consumed = 0;
+	if (sscanf(start, "%lf %lf %lf %lf %n", &bounds[0], &bounds[1], &bounds[2], &bounds[3], &consumed) == 4 && consumed > 0 && start[consumed] != 0) {
+		start += consumed;
+	} else {
+		bounds[0] = bounds[1] = bounds[2] = bounds[3] = NAN;
+	}
+
+	*path = start;
+
+	return 1;
+}
+
+granule_list* read_granule_list(const char* file) {
+
+	FILE* fp = strcmp(file, "-") == 0 ? stdin : fopen(file, "r");
+	if (fp == NULL) return NULL;
+
+	granule_list* gl = calloc(1, sizeof(granule_list));
+	int allocated = 16;
+	gl->paths = malloc(sizeof(char*) * allocated);
+	gl->bounds = malloc(sizeof(double) * 4 * allocated);
+
+	char line[GRANULE_LINE_LEN];
+	while (fgets(line, GRANULE_LINE_LEN, fp) != NULL) {
+
+		if (gl->count == allocated) {
+			allocated *= 2;
+			gl->paths = realloc(gl->paths, sizeof(char*) * allocated);
+			gl->bounds = realloc(gl->bounds, sizeof(double) * 4 * allocated);
+		}
+
+		char* path;
+		if (!parse_granule_line(line, &path, &gl->bounds[4 * gl->count])) continue;
+
+		gl->paths[gl->count++] = strdup(path);
+	}
+
+	if (fp != stdin) fclose(fp);
+
+	gl->rows = calloc(gl->count > 0 ? gl->count : 1, sizeof(int));
+	gl->cols = calloc(gl->count > 0 ? gl->count : 1, sizeof(int));
+
+	if (DEBUG_VIRTUAL) printf("read %d granules from %s\n", gl->count, file);
+
+	return gl;
+}
+
+void set_granule_times(granule_list* gl, const char* time_table, double window, double km_per_unit) {
+
+	split_table_path(time_table, &gl->group_time, &gl->name_time);
+	gl->time_window = window;
+	gl->time_km_per_unit = km_per_unit;
+
+	int granule_count = gl->count > 0 ? gl->count : 1;
+	gl->times = calloc(granule_count, sizeof(scan_times*));
+	gl->time_range = malloc(sizeof(double) * 2 * granule_count);
+
+	int g;
+	for (g = 0; g < 2 * granule_count; g++) gl->time_range[g] = NAN;
+}
+
+// Scan times and time range of granule g (rows described), 0 when its TimeTable cannot be read
+int read_granule_times(granule_list* gl, int g) {
+
+	scan_times* st = read_scan_times(gl->paths[g], gl->group_time, gl->name_time, gl->rows[g]);
+	if (st == NULL) return 0;
+
+	st->window = gl->time_window;
+	st->km_per_unit = gl->time_km_per_unit;
+	gl->times[g] = st;
+
+	int s;
+	for (s = 0; s < st->scans; s++) {
+		if (isnan(st->time[s])) continue;
+		if (!(st->time[s] >= gl->time_range[2 * g])) gl->time_range[2 * g] = st->time[s];
+		if (!(st->time[s] <= gl->time_range[2 * g + 1])) gl->time_range[2 * g + 1] = st->time[s];
+	}
+
+	return 1;
+}
+
+// Without -t or a target time every granule is in time, a granule without scan times never is
+int granule_in_time(granule_list* gl, int g, double time) {
+
+	if (gl->times == NULL || isnan(time)) return 1;
+
+	// NAN (no valid scan) fails both tests
+	return time >= gl->time_range[2 * g] - gl->time_window && time <= gl->time_range[2 * g + 1] + gl->time_window;
+}
+
+// Row penalties of granule g for a target (scan_penalty), NULL without -t or a target time
+const double* granule_penalty(granule_list* gl, int g, double time) {
+	if (gl->times == NULL || gl->times[g] == NULL) return NULL;
+	return scan_penalty(gl->times[g], time);
+}
+
+void free_granule_band(granule_band* band) {
+	free_geolocation(band->lat);
+	free_geolocation(band->lon);
+	free_validity_mask(band->mask);
+	memset(band, 0, sizeof(granule_band));
+	band->granule = -1;
+}
+
+// Target within max_km of the bounds listed for granule g, or no bounds listed
+int granule_near(granule_list* gl, int g, double lat, double lon, double max_km) {
+
+	double* b = &gl->bounds[4 * g];
+	if (isnan(b[0])) return 1;
+
+	double margin = max_km / 111.;
+	if (lat < b[0] - margin || lat > b[1] + margin) return 0;
+
+	double cos_lat = cos(lat * M_PI / 180.);
+	if (cos_lat < 0.01) return 1;
+	margin /= cos_lat;
+
+	int k;
+	for (k = -1; k <= 1; k++) {
+		if (lon + 360. * k >= b[2] - margin && lon + 360. * k <= b[3] + margin) return 1;
+	}
+	return 0;
+}
+
+// Rows [row0, row0 + rows) of a granule, clipped to it
+int load_granule_band(granule_list* gl, int g, int row0, int rows, const char* group_lat, const char* name_lat, const char* group_lon, const char* name_lon, granule_band* band) {
+
+	// Never described, no target is near it
+	if (gl->rows[g] == 0) {
+		band->granule = g;
+		return 0;
+	}
+
+	if (row0 < 0) {
+		rows += row0;
+		row0 = 0;
+	}
+	if (row0 + rows > gl->rows[g]) rows = gl->rows[g] - row0;
+
+	hsize_t start[2] = { row0, 0 };
+	hsize_t count[2] = { rows > 0 ? rows : 0, gl->cols[g] };
+
+	band->granule = g;
+	band->row0 = row0;
+	band->lat = load_geolocation_window(gl->paths[g], group_lat, name_lat, start, NULL, count);
+	band->lon = load_geolocation_window(gl->paths[g], group_lon, name_lon, start, NULL, count);
+
+	if (band->lat == NULL || band->lon == NULL) {
+		free_granule_band(band);
+		return 0;
+	}
+
+	band->mask = build_validity_mask(band->lat, band->lon);
+	stats.virtual_band_rows += rows;
+
+	return 1;
+}
+
+// Moves target t to the band's granule if the band holds a nearer pixel. With row_penalty
+// (the band's rows, -t) pixels rank as in scan_penalty, found_penalty is that of t's match.
+void search_granule_band(granule_band* band, lookup_target* t, const double* row_penalty, double found_penalty) {
+
+	if (band->granule < 0 || band->mask == NULL || band->mask->valid == 0) return;
+
+	int* indices = row_penalty != NULL
+		? (int*) get_indices_from_geo_timed(band->lat, band->lon, band->mask, row_penalty, t->lat, t->lon)
+		: (int*) get_indices_from_geo_tables(band->lat, band->lon, band->mask, t->lat, t->lon);
+	int row = indices[0], col = indices[1];
+	free(indices);
+
+	if (row < 0) return;
+
+	double obs_lat = geo_value(band->lat, row, col);
+	double obs_lon = geo_value(band->lon, row, col);
+	double distance = gc_distance(obs_lat, obs_lon, t->lat, t->lon);
+
+	double penalty = row_penalty != NULL ? row_penalty[row] : 0;
+	if (t->found && hypot(distance, penalty) >= hypot(t->distance, found_penalty)) return;
+
+	t->found = 1;
+	t->granule = band->granule;
+	t->row = band->row0 + row;
+	t->col = col;
+	t->obs_lat = obs_lat;
+	t->obs_lon = obs_lon;
+	t->distance = distance;
+}
+
+H5T_class_t extract_virtual_variable(granule_list* gl, const char* table, lookup_target* targets, int count, lookup_value* values) {
+
+	H5T_class_t data_type = H5T_NO_CLASS;
+
+	lookup_target* subset = malloc(sizeof(lookup_target) * (count > 0 ? count : 1));
+	lookup_value* subset_values = malloc(sizeof(lookup_value) * (count > 0 ? count : 1));
+
+	int g, i;
+	for (g = 0; g < gl->count; g++) {
+
+		int located = 0;
+		for (i = 0; i < count; i++) {
+			subset[i] = targets[i];
+			subset[i].found = targets[i].found && targets[i].granule == g;
+			located += subset[i].found;
+		}
+		if (located == 0) continue;
+
+		data_type = extract_variable(gl->paths[g], table, subset, count, gl->rows[g], gl->cols[g], subset_values);
+
+		for (i = 0; i < count; i++) {
+			if (subset[i].found) values[i] = subset_values[i];
+		}
+	}
+
+	free(subset);
+	free(subset_values);
+
+	return data_type;
+}
+
+void read_granule_job(void* arg) {
+	granule_read* r = (granule_read*) arg;
+	r->lat = load_geolocation(r->gl->paths[r->granule], r->group_lat, r->name_lat, r->threads, 1);
+	r->lon = load_geolocation(r->gl->paths[r->granule], r->group_lon, r->name_lon, r->threads, 1);
+}
+
+void read_variables_job(void* arg) {
+	variable_read* r = (variable_read*) arg;
+	int v;
+	for (v = 0; v < r->variable_count; v++) {
+		H5T_class_t data_type = extract_virtual_variable(r->gl, r->variables[v], r->subset, r->count, &r->values[v * r->count]);
+		if (data_type != H5T_NO_CLASS) r->data_types[v] = data_type;
+	}
+}
+
+#define ADVISE_NONE 0
+#define ADVISE_AHEAD 1				// WILLNEED given
+#define ADVISE_RELEASED 2			// DONTNEED given, never advised again
+
+// Advice on both tables of granule g, taking turns on HDF5 with the I/O thread
+void advise_granule(io_pipeline* io, granule_list* gl, int g, int* advised, int advice, const char* group_lat, const char* name_lat, const char* group_lon, const char* name_lon) {
+
+	io_hdf5_lock(io);
+	size_t bytes = advise_variable_by_name(gl->paths[g], group_lat, name_lat, advice) + advise_variable_by_name(gl->paths[g], group_lon, name_lon, advice);
+	io_hdf5_unlock(io);
+
+	if (advice == POSIX_FADV_WILLNEED) {
+		advised[g] = ADVISE_AHEAD;
+		stats.readahead_bytes += bytes;
+	} else {
+		advised[g] = ADVISE_RELEASED;
+		stats.readahead_released += bytes;
+	}
+}
+
+// WILLNEED for granule g and the next ahead granules wanted by the pass
+void advise_granules_ahead(io_pipeline* io, granule_list* gl, const int* wanted, int g, int ahead, int* advised, const char* group_lat, const char* name_lat, const char* group_lon, const char* name_lon) {
+
+	int h, found = 0;
+	for (h = g; h < gl->count && found <= ahead && ahead > 0; h++) {
+		if (!wanted[h]) continue;
+		found++;
+		if (advised[h] == ADVISE_NONE) advise_granule(io, gl, h, advised, POSIX_FADV_WILLNEED, group_lat, name_lat, group_lon, name_lon);
+	}
+}
+
+void release_granule(io_pipeline* io, granule_list* gl, int g, int* advised, const char* group_lat, const char* name_lat, const char* group_lon, const char* name_lon) {
+	if (advised[g] == ADVISE_AHEAD) advise_granule(io, gl, g, advised, POSIX_FADV_DONTNEED, group_lat, name_lat, group_lon, name_lon);
+}
+
+// values and data_types receive the variables, read with io_depth granules ahead (0 for none),
+// readahead granules are advised into the page cache (0 for none)
+void locate_virtual_swath(granule_list* gl, const char* lat_table, const char* lon_table, lookup_target* targets, int count, int threads, double raster_cell, int raster_sidecar, double max_km,
+	char** variables, int variable_count, lookup_value* values, H5T_class_t* data_types, int io_depth, int readahead) {
+
+	char *group_lat, *name_lat, *group_lon, *name_lon;
+	split_table_path(lat_table, &group_lat, &name_lat);
+	split_table_path(lon_table, &group_lon, &name_lon);
+
+	int* home = malloc(sizeof(int) * (count > 0 ? count : 1));
+	double* home_distance = malloc(sizeof(double) * (count > 0 ? count : 1));
+	int g, i;
+
+	for (i = 0; i < count; i++) {
+		home[i] = -1;
+		home_distance[i] = 99999;
+		targets[i].found = 0;
+	}
+
+	io_pipeline* io = start_io_pipeline(io_depth);
+
+	int granule_count = gl->count > 0 ? gl->count : 1;
+	int* near = calloc(granule_count, sizeof(int));
+	int* homed = calloc(granule_count, sizeof(int));
+	int* advised = calloc(granule_count, sizeof(int));
+
+	for (g = 0; g < gl->count; g++) {
+		for (i = 0; i < count; i++) near[g] += granule_near(gl, g, targets[i].lat, targets[i].lon, max_km);
+	}
+
+	// 1. Footprints, every target's home granule
+	for (g = 0; g < gl->count; g++) {
+		if (near[g] == 0) continue;
+
+		advise_granules_ahead(io, gl, near, g, readahead, advised, group_lat, name_lat, group_lon, name_lon);
+
+		geo_table described;
+		if (!describe_geo_table(gl->paths[g], group_lat, name_lat, &described)) continue;
+
+		gl->rows[g] = described.rows;
+		gl->cols[g] = described.cols;
+
+		// Scan times, only the targets within the window of the granule's range are sampled for
+		if (gl->times != NULL) {
+			if (!read_granule_times(gl, g)) {
+				fprintf(stderr, "Unable to read %s%s of %s, skipped\n", gl->group_time, gl->name_time, gl->paths[g]);
+				gl->rows[g] = 0;
+				continue;
+			}
+
+			near[g] = 0;
+			for (i = 0; i < count; i++) {
+				if (!granule_near(gl, g, targets[i].lat, targets[i].lon, max_km)) continue;
+				if (granule_in_time(gl, g, targets[i].time)) near[g]++;
+				else stats.virtual_time_pruned++;
+			}
+			if (near[g] == 0) continue;
+		}
+
+		hsize_t start[2] = { 0, 0 };
+		hsize_t stride[2] = { VIRTUAL_FOOTPRINT_STRIDE, VIRTUAL_FOOTPRINT_STRIDE };
+		hsize_t samples[2] = { (described.rows + VIRTUAL_FOOTPRINT_STRIDE - 1) / VIRTUAL_FOOTPRINT_STRIDE, (described.cols + VIRTUAL_FOOTPRINT_STRIDE - 1) / VIRTUAL_FOOTPRINT_STRIDE };
+
+		geo_table* lat = load_geolocation_window(gl->paths[g], group_lat, name_lat, start, stride, samples);
+		geo_table* lon = load_geolocation_window(gl->paths[g], group_lon, name_lon, start, stride, samples);
+
+		if (lat != NULL && lon != NULL && lat->rows == lon->rows && lat->cols == lon->cols) {
+			validity_mask* mask = build_validity_mask(lat, lon);
+
+			for (i = 0; i < count && mask->valid > 0; i++) {
+				if (!granule_near(gl, g, targets[i].lat, targets[i].lon, max_km) || !granule_in_time(gl, g, targets[i].time)) continue;
+
+				int* indices = (int*) get_indices_from_geo_tables(lat, lon, mask, targets[i].lat, targets[i].lon);
+				double distance = gc_distance(geo_value(lat, indices[0], indices[1]), geo_value(lon, indices[0], indices[1]), targets[i].lat, targets[i].lon);
+				free(indices);
+
+				if (distance < home_distance[i]) {
+					home[i] = g;
+					home_distance[i] = distance;
+				}
+			}
+
+			free_validity_mask(mask);
+		}
+
+		free_geolocation(lat);
+		free_geolocation(lon);
+	}
+
+	granule_band before, after;
+	memset(&before, 0, sizeof(granule_band));
+	memset(&after, 0, sizeof(granule_band));
+	before.granule = after.granule = -1;
+
+	for (i = 0; i < count; i++) {
+		if (home[i] >= 0) homed[home[i]]++;
+	}
+
+	// Sampled granules no target calls home are done with
+	for (g = 0; g < gl->count; g++) {
+		if (!homed[g]) release_granule(io, gl, g, advised, group_lat, name_lat, group_lon, name_lon);
+	}
+
+	// 2. Home granules in order, one held at a time (and io_depth read ahead)
+	int homes = 0, k;
+	granule_read* granule_reads = calloc(granule_count, sizeof(granule_read));
+	variable_read* variable_reads = calloc(granule_count, sizeof(variable_read));
+
+	for (g = 0; g < gl->count; g++) {
+		if (!homed[g]) continue;
+
+		granule_read* r = &granule_reads[homes++];
+		r->gl = gl;
+		r->granule = g;
+		r->group_lat = group_lat;
+		r->name_lat = name_lat;
+		r->group_lon = group_lon;
+		r->name_lon = name_lon;
+		r->threads = threads;
+	}
+
+	for (i = 0; i < variable_count; i++) data_types[i] = H5T_NO_CLASS;
+
+	int submitted = 0;
+
+	for (k = 0; k < homes; k++) {
+
+		advise_granules_ahead(io, gl, homed, granule_reads[k].granule, readahead, advised, group_lat, name_lat, group_lon, name_lon);
+
+		while (submitted < homes && submitted <= k + io->depth) {
+			io_submit(io, IO_AHEAD, read_granule_job, &granule_reads[submitted], &granule_reads[submitted].done);
+			submitted++;
+		}
+		io_wait(io, &granule_reads[k].done);
+
+		g = granule_reads[k].granule;
+		geo_table* data_lat = granule_reads[k].lat;
+		geo_table* data_lon = granule_reads[k].lon;
+
+		if (data_lat == NULL || data_lon == NULL || data_lat->rows != data_lon->rows || data_lat->cols != data_lon->cols) {
+			fprintf(stderr, "Unable to read the geolocation of %s, skipped\n", gl->paths[g]);
+			free_geolocation(data_lat);
+			free_geolocation(data_lon);
+			continue;
+		}
+
+		stats.virtual_granules_loaded++;
+		stats.geolocation_elements += 2 * (size_t) data_lat->rows * data_lat->cols;
+
+		validity_mask* mask = build_validity_mask(data_lat, data_lon);
+		stats.geolocation_valid += mask->valid;
+
+		geolocation geo = { gl->paths[g], group_lat, name_lat, group_lon, name_lon, data_lat->rows, data_lat->cols, data_lat, data_lon, mask };
+
+		if (raster_cell > 0) {
+			int cached;
+			geo.raster = granule_raster(gl->paths[g], lat_table, lon_table, NULL, raster_cell, data_lat, data_lon, mask, threads, raster_sidecar, &cached);
+			if (geo.raster != NULL) {
+				geo.raster->search_km = max_km;
+				stats.raster_cells += geo.raster->nlat * geo.raster->nlon;
+				stats.raster_cached += cached;
+			}
+		}
+
+		for (i = 0; i < count; i++) {
+			if (home[i] != g) continue;
+
+			lookup_target* t = &targets[i];
+
+			geo.row_penalty = granule_penalty(gl, g, t->time);
+
+			t->found = locate_pixel(&geo, t->lat, t->lon, &t->row, &t->col, &t->obs_lat, &t->obs_lon);
+			t->granule = g;
+			if (t->found) t->distance = gc_distance(t->obs_lat, t->obs_lon, t->lat, t->lon);
+
+			double found_penalty = t->found && geo.row_penalty != NULL ? geo.row_penalty[t->row] : 0;
+
+			// 3. Boundary rows of the neighbours, for targets matched near an edge (and in time for the neighbour)
+			if (t->found && t->row < VIRTUAL_EDGE_ROWS && g > 0) {
+				if (granule_in_time(gl, g - 1, t->time)) {
+					if (before.granule != g - 1) {
+						free_granule_band(&before);
+						io_hdf5_lock(io);
+						load_granule_band(gl, g - 1, gl->rows[g - 1] - VIRTUAL_EDGE_ROWS, VIRTUAL_EDGE_ROWS, group_lat, name_lat, group_lon, name_lon, &before);
+						io_hdf5_unlock(io);
+					}
+					const double* penalty = granule_penalty(gl, g - 1, t->time);
+					search_granule_band(&before, t, penalty != NULL ? penalty + before.row0 : NULL, found_penalty);
+				}
+			} else if (t->found && t->row >= geo.rows - VIRTUAL_EDGE_ROWS && g < gl->count - 1) {
+				if (granule_in_time(gl, g + 1, t->time)) {
+					if (after.granule != g + 1) {
+						free_granule_band(&after);
+						io_hdf5_lock(io);
+						load_granule_band(gl, g + 1, 0, VIRTUAL_EDGE_ROWS, group_lat, name_lat, group_lon, name_lon, &after);
+						io_hdf5_unlock(io);
+					}
+					const double* penalty = granule_penalty(gl, g + 1, t->time);
+					search_granule_band(&after, t, penalty != NULL ? penalty + after.row0 : NULL, found_penalty);
+				}
+			}
+
+			if (t->found && gl->times != NULL && gl->times[t->granule] != NULL) {
+				scan_times* st = gl->times[t->granule];
+				t->obs_time = st->time[t->row / st->rows_per_scan];
+			}
+
+			if (t->found && t->distance >= max_km) t->found = 0;
+		}
+
+		// The home granule's targets are final, their variables are read behind the search
+		variable_read* r = &variable_reads[k];
+		r->gl = gl;
+		r->variables = variables;
+		r->variable_count = variable_count;
+		r->subset = malloc(sizeof(lookup_target) * count);
+		r->count = count;
+		r->values = values;
+		r->data_types = data_types;
+
+		for (i = 0; i < count; i++) {
+			r->subset[i] = targets[i];
+			r->subset[i].found = targets[i].found && home[i] == g;
+		}
+
+		io_submit(io, IO_BEHIND, read_variables_job, r, &r->done);
+
+		if (geo.raster != NULL) stats.raster_visited += geo.raster->visited;
+
+		free_inverse_raster(geo.raster);
+		free_validity_mask(mask);
+		free_geolocation(data_lat);
+		free_geolocation(data_lon);
+
+		// The granule before is past any boundary band now
+		if (k > 0) release_granule(io, gl, granule_reads[k - 1].granule, advised, group_lat, name_lat, group_lon, name_lon);
+	}
+
+	if (homes > 0) release_granule(io, gl, granule_reads[homes - 1].granule, advised, group_lat, name_lat, group_lon, name_lon);
+
+	finish_io_pipeline(io);
+
+	for (k = 0; k < homes; k++) free(variable_reads[k].subset);
+	free(granule_reads);
+	free(variable_reads);
+
+	free_granule_band(&before);
+	free_granule_band(&after);
+
+	if (DEBUG_VIRTUAL) printf("virtual swath: %d granules, %lu loaded, %lu band rows\n",
+		gl->count, (unsigned long) stats.virtual_granules_loaded, (unsigned long) stats.virtual_band_rows);
+
+	free(home);
+	free(home_distance);
+	free(near);
+	free(homed);
+	free(advised);
+	free(group_lat);
+	free(name_lat);
+	free(group_lon);
+	free(name_lon);
+}
+
+void free_granule_list(granule_list* gl) {
+	if (gl == NULL) return;
+	int g;
+	for (g = 0; g < gl->count; g++) free(gl->paths[g]);
+	free(gl->paths);
+	free(gl->rows);
+	free(gl->cols);
+	free(gl->bounds);
+	if (gl->times != NULL) {
+		for (g = 0; g < gl->count; g++) free_scan_times(gl->times[g]);
+	}
+	free(gl->times);
+	free(gl->time_range);
+	free(gl->group_time);
+	free(gl->name_time);
+	free(gl);
+}
@@ -0,0 +1,298 @@
+/*
+ *	Program: HDF5 Lookup v0.1
+ *
+ *	Usage: This code is free to use and modify, so long
+ *		as this header remains intact, except for
+ *		"Modifications" below.
+ *
+ *	Purpose: Directory watch (-D Dir), new granules indexed in the
+ *		background so queries never build an index themselves. File is
+ *		then the query catalog, a -G granule list (virtual.c) with each
+ *		granule's bounds:
+ *
+ *			south north west east path
+ *
+ *		inotify reports files closed after writing or moved into Dir.
+ *		Each is queued to the -j worker pool (one worker by default),
+ *		which reads LatTable/LonTable, takes the footprint bounds, builds
+ *		the -r raster (default WATCH_RASTER_DEG) and writes the File.raster
+ *		sidecar (raster.c). Only then is the granule published, by
+ *		writing the catalog with the new line to a temporary file and
+ *		renaming it over the old one, so a reader sees the old or the new
+ *		catalog, never a partial one, and never a granule without its
+ *		sidecar. A granule rewritten in place replaces its own line.
+ *		Queries use the catalog as File with -G -r deg -c.
+ *
+ *		HDF5 is not thread safe, workers take turns reading geolocation
+ *		and overlap on the raster builds and sidecar writes.
+ *
+ *		Hidden files, sidecars and files HDF5 cannot open are ignored.
+ *		The watch runs until interrupted (SIGINT, SIGTERM).
+ *
+ *	Functions
+ *		int			watch_directory		- index and publish the granules landing in a directory
+ *
+ *	Modifications:
+ *		2026 10 18 - Initial Version
+ */
+
+#include <sys/inotify.h>
+#include <poll.h>
+#include <signal.h>
+
+#define DEBUG_WATCH 0
+
+#define WATCH_RASTER_DEG 0.05		// -r default in watch mode
+#define WATCH_QUEUE 1024
+#define WATCH_POLL_MS 500
+#define WATCH_EVENT_BYTES (64 * 1024)
+
+typedef struct {
+	const char* dir;			// absolute
+	const char* catalog;
+	const char* lat_table;
+	const char* lon_table;
+	char* group_lat;
+	char* name_lat;
+	char* group_lon;
+	char* name_lon;
+	double cell;
+	char* queue[WATCH_QUEUE];	// paths waiting for a worker, under lock
+	int head;
+	int count;
+	int stopping;
+	pthread_mutex_t lock;
+	pthread_cond_t queued;
+	pthread_mutex_t hdf5_lock;
+	pthread_mutex_t catalog_lock;
+	size_t published;
+} watch_job;
+
+volatile sig_atomic_t watch_interrupted = 0;
+
+void watch_interrupt(int signal) {
+	watch_interrupted = 1;
+}
+
+// Appends the line to a copy of the catalog without path's old line, renamed over it
+int publish_granule(watch_job* job, const char* path, const char* line) {
+
+	pthread_mutex_lock(&job->catalog_lock);
+
+	char* tmp = malloc(strlen(job->catalog) + 16);
+	sprintf(tmp, "%s.%d", job->catalog, (int) getpid());
+
+	int ok = 0;
+	FILE* out = fopen(tmp, "w");
+	if (out != NULL) {
+		FILE* in = fopen(job->catalog, "r");
+		if (in != NULL) {
+			char buffer[GRANULE_LINE_LEN];
+			char parsed[GRANULE_LINE_LEN];
+			while (fgets(buffer, GRANULE_LINE_LEN, in) != NULL) {
+				char* listed;
+				double bounds[4];
+				strcpy(parsed, buffer);
+				if (parse_granule_line(parsed, &listed, bounds) && strcmp(listed, path) == 0) continue;
+				fputs(buffer, out);
+			}
+			fclose(in);
+		} else {
+			fprintf(out, "# south north west east path\n");
+		}
+
+		fprintf(out, "%s\n", line);
+
+		ok = fclose(out) == 0 && rename(tmp, job->catalog) == 0;
+		if (!ok) remove(tmp);
+	}
+
+	if (ok) job->published++;
+
+	pthread_mutex_unlock(&job->catalog_lock);
+
+	free(tmp);
+
+	return ok;
+}
+
+void index_granule(watch_job* job, const char* path) {
+
+	pthread_mutex_lock(&job->hdf5_lock);
+
+	geo_table* lat = NULL;
+	geo_table* lon = NULL;
+
+	if (H5Fis_hdf5(path) > 0) {
+		lat = load_geolocation(path, job->group_lat, job->name_lat, 0, 1);
+		lon = load_geolocation(path, job->group_lon, job->name_lon, 0, 1);
+	}
+
+	pthread_mutex_unlock(&job->hdf5_lock);
+
+	if (lat == NULL || lon == NULL || lat->rows != lon->rows || lat->cols != lon->cols) {
+		if (DEBUG_WATCH) printf("watch: %s skipped\n", path);
+		free_geolocation(lat);
+		free_geolocation(lon);
+		return;
+	}
+
+	validity_mask* mask = build_validity_mask(lat, lon);
+
+	// Footprint bounds over the valid pixels
+	double south = 90, north = -90, west = 180, east = -180;
+	int row, col;
+	for (row = 0; row < lat->rows; row++) {
+		for (col = 0; col < lat->cols; col++) {
+			if (!validity_test(mask, row, col)) continue;
+
+			double pixel_lat = geo_value(lat, row, col);
+			double pixel_lon = geo_value(lon, row, col);
+
+			if (pixel_lat < south) south = pixel_lat;
+			if (pixel_lat > north) north = pixel_lat;
+			if (pixel_lon < west) west = pixel_lon;
+			if (pixel_lon > east) east = pixel_lon;
+		}
+	}
+
+	int cached;
+	inverse_raster* raster = mask->valid > 0 ? granule_raster(path, job->lat_table, job->lon_table, NULL, job->cell, lat, lon, mask, 1, 1, &cached) : NULL;
+
+	if (raster != NULL) {
+		char line[GRANULE_LINE_LEN];
+		snprintf(line, GRANULE_LINE_LEN, "%f %f %f %f %s", south, north, west, east, path);
+
+		if (!publish_granule(job, path, line)) fprintf(stderr, "Unable to publish %s to %s\n", path, job->catalog);
+		else if (DEBUG_WATCH) printf("watch: published %s\n", line);
+	}
+
+	free_inverse_raster(raster);
+	free_validity_mask(mask);
+	free_geolocation(lat);
+	free_geolocation(lon);
+}
+
+void* watch_worker(void* arg) {
+
+	watch_job* job = (watch_job*) arg;
+
+	while (1) {
+		pthread_mutex_lock(&job->lock);
+		while (job->count == 0 && !job->stopping) pthread_cond_wait(&job->queued, &job->lock);
+
+		if (job->count == 0) {
+			pthread_mutex_unlock(&job->lock);
+			break;
+		}
+
+		char* path = job->queue[job->head];
+		job->head = (job->head + 1) % WATCH_QUEUE;
+		job->count--;
+		pthread_mutex_unlock(&job->lock);
+
+		index_granule(job, path);
+		free(path);
+	}
+
+	return NULL;
+}
+
+int watched_name(const char* name) {
+	size_t len = strlen(name);
+	return name[0] != '.' && strstr(name, ".raster") == NULL && !(len > 4 && strcmp(name + len - 4, ".tmp") == 0);
+}
+
+int watch_directory(const char* dir, const char* catalog, const char* lat_table, const char* lon_table, double cell, int workers) {
+
+	// Catalog lines name granules by absolute path
+	int fd = inotify_init1(IN_NONBLOCK);
+	if (fd < 0 || inotify_add_watch(fd, dir, IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+		if (fd >= 0) close(fd);
+		return 0;
+	}
+
+	watch_job job;
+	memset(&job, 0, sizeof(watch_job));
+	job.dir = realpath(dir, NULL);
+	job.catalog = catalog;
+	job.lat_table = lat_table;
+	job.lon_table = lon_table;
+	job.cell = cell;
+	split_table_path(lat_table, &job.group_lat, &job.name_lat);
+	split_table_path(lon_table, &job.group_lon, &job.name_lon);
+	pthread_mutex_init(&job.lock, NULL);
+	pthread_cond_init(&job.queued, NULL);
+	pthread_mutex_init(&job.hdf5_lock, NULL);
+	pthread_mutex_init(&job.catalog_lock, NULL);
+
+	if (workers < 1) workers = 1;
+
+	pthread_t* pool = malloc(sizeof(pthread_t) * workers);
+	int w;
+	for (w = 0; w < workers; w++) pthread_create(&pool[w], NULL, watch_worker, &job);
+
+	signal(SIGINT, watch_interrupt);
+	signal(SIGTERM, watch_interrupt);
+
+	char* events = malloc(WATCH_EVENT_BYTES);
+	struct pollfd pfd = { fd, POLLIN, 0 };
+
+	while (!watch_interrupted) {
+		if (poll(&pfd, 1, WATCH_POLL_MS) <= 0) continue;
+
+		ssize_t length = read(fd, events, WATCH_EVENT_BYTES);
+		ssize_t offset = 0;
+
+		while (length > 0 && offset < length) {
+			struct inotify_event* event = (struct inotify_event*) (events + offset);
+			offset += sizeof(struct inotify_event) + event->len;
+
+			if (event->len == 0 || (event->mask & IN_ISDIR) || !watched_name(event->name)) continue;
+
+			char* path = malloc(strlen(job.dir) + event->len + 2);
+			sprintf(path, "%s/%s", job.dir, event->name);
+
+			pthread_mutex_lock(&job.lock);
+			if (job.count < WATCH_QUEUE) {
+				job.queue[(job.head + job.count) % WATCH_QUEUE] = path;
+				job.count++;
+				pthread_cond_signal(&job.queued);
+				path = NULL;
+			}
+			pthread_mutex_unlock(&job.lock);
+
+			if (path != NULL) {
+				fprintf(stderr, "Watch queue full, %s not indexed\n", path);
+				free(path);
+			}
+		}
+	}
+
+	// Granules already queued are still published
+	pthread_mutex_lock(&job.lock);
+	job.stopping = 1;
+	pthread_cond_broadcast(&job.queued);
+	pthread_mutex_unlock(&job.lock);
+
+	for (w = 0; w < workers; w++) pthread_join(pool[w], NULL);
+
+	if (DEBUG_WATCH) printf("watch %s: %lu published\n", dir, (unsigned long) job.published);
+
+	stats.watch_published = job.published;
+
+	free(pool);
+	free(events);
+	free((char*) job.dir);
+	free(job.group_lat);
+	free(job.name_lat);
+	free(job.group_lon);
+	free(job.name_lon);
+	pthread_mutex_destroy(&job.lock);
+	pthread_cond_destroy(&job.queued);
+	pthread_mutex_destroy(&job.hdf5_lock);
+	pthread_mutex_destroy(&job.catalog_lock);
+	close(fd);
+
+	return 1;
+}
@@ -0,0 +1,188 @@
+/*
+ *	Program: HDF5 Lookup v0.1
+ *
+ *	Usage: This code is free to use and modify, so long
+ *		as this header remains intact, except for
+ *		"Modifications" below.
+ *
+ *	Purpose: Neighborhood windows (-w N raw, -W N statistics). The N x N
+ *		box of each variable centered on the located pixel, at the
+ *		variable's own resolution, for validation protocols that compare
+ *		a 3x3 or 5x5 mean rather than a single value.
+ *
+ *		Each window is one hyperslab read of the box clipped to the
+ *		dataset, targets taken in row/col order so neighbouring windows
+ *		reuse the chunks in the chunk cache. Positions outside the
+ *		granule are NAN.
+ *
+ *		-w prints the N * N values row by row, "nan" outside the granule.
+ *		-W prints valid_count mean stddev (sample) of the values inside
+ *		the granule that are not the variable's _FillValue.
+ *
+ *	Functions
+ *		int			extract_windows		- N x N windows of one variable for every located target
+ *		void		print_window		- raw values or statistics of one window, to fp
+ *
+ *	Modifications:
+ *		2026 10 18 - Initial Version
+ */
+
+#define DEBUG_WINDOW 0
+
+#define MAX_WINDOW 101
+
+typedef struct {
+	H5T_class_t data_type;
+	int has_fill;				// _FillValue attribute
+	double fill;
+} window_variable;
+
+// windows holds count * size * size values, target i at i * size * size
+int extract_windows(const char* path, const char* table, lookup_target* targets, int count, int ll_rows, int ll_cols, int size, double* windows, window_variable* info) {
+
+	char *group_dat, *name_dat;
+	split_table_path(table, &group_dat, &name_dat);
+
+	hid_t* ids     = (hid_t*) get_variable_ids_by_name(path, group_dat, name_dat);
+	hid_t h5id     = ids[0];
+	hid_t grp_h5id = ids[1];
+	hid_t varid    = ids[2];
+	free(ids);
+
+	info->data_type = get_variable_type(varid);
+	info->has_fill = H5Aexists(varid, "_FillValue") > 0;
+	info->fill = read_scalar_attribute(varid, "_FillValue", 0.);
+
+	hid_t dataset_space = H5Dget_space(varid);
+	int ndims = H5Sget_simple_extent_ndims(dataset_space);
+	hsize_t dims[2] = { 0, 0 };
+	if (ndims == 2) H5Sget_simple_extent_dims(dataset_space, dims, NULL);
+	H5Sclose(dataset_space);
+
+	int ok = ndims == 2 && (info->data_type == H5T_INTEGER || info->data_type == H5T_FLOAT);
+
+	// Enough cache for the chunks under one window
+	hid_t dcpl = H5Dget_create_plist(varid);
+	hsize_t chunk[2];
+	if (ok && H5Pget_layout(dcpl) == H5D_CHUNKED && H5Pget_chunk(dcpl, 2, chunk) == 2) {
+		hid_t file_type = H5Dget_type(varid);
+		size_t chunk_bytes = chunk[0] * chunk[1] * H5Tget_size(file_type);
+		H5Tclose(file_type);
+
+		size_t window_chunks = ((size - 1) / chunk[0] + 2) * ((size - 1) / chunk[1] + 2);
+		size_t cache_bytes = window_chunks * chunk_bytes;
+		if (cache_bytes > CHUNK_CACHE_MAX_BYTES) cache_bytes = CHUNK_CACHE_MAX_BYTES;
+		if (cache_bytes < chunk_bytes) cache_bytes = chunk_bytes;
+
+		H5Dclose(varid);
+		varid = open_variable_with_chunk_cache(grp_h5id, name_dat, cache_bytes, chunk_bytes);
+
+		if (cache_bytes > stats.chunk_cache_bytes) stats.chunk_cache_bytes = cache_bytes;
+	}
+	H5Pclose(dcpl);
+
+	int half = size / 2;
+	int area = size * size;
+	int i, k;
+
+	for (i = 0; i < count * area; i++) windows[i] = NAN;
+
+	int* located = malloc(sizeof(int) * (count > 0 ? count : 1));
+	unsigned long* keys = malloc(sizeof(unsigned long) * (count > 0 ? count : 1));
+	int located_count = 0;
+
+	for (i = 0; ok && i < count; i++) {
+		if (!targets[i].found) continue;
+
+		int r = scale_index(targets[i].row, ll_rows, dims[0]);
+		int c = scale_index(targets[i].col, ll_cols, dims[1]);
+
+		located[located_count] = i;
+		keys[located_count] = (unsigned long) r * dims[1] + c;
+		located_count++;
+	}
+
+	int* plan = plan_by_key(keys, located_count);
+	double* box = malloc(sizeof(double) * area);
+
+	for (k = 0; k < located_count; k++) {
+		int t = located[plan[k]];
+		long r = keys[plan[k]] / dims[1];
+		long c = keys[plan[k]] % dims[1];
+
+		// Clip the box to the dataset
+		long r0 = r - half < 0 ? 0 : r - half;
+		long c0 = c - half < 0 ? 0 : c - half;
+		long r1 = r + half > (long) dims[0] - 1 ? (long) dims[0] - 1 : r + half;
+		long c1 = c + half > (long) dims[1] - 1 ? (long) dims[1] - 1 : c + half;
+
+		hsize_t start[2] = { r0, c0 };
+		hsize_t extent[2] = { r1 - r0 + 1, c1 - c0 + 1 };
+
+		if (read_variable_hyperslab(varid, H5T_NATIVE_DOUBLE, start, NULL, extent, box) < 0) {
+			ok = 0;
+			break;
+		}
+
+		stats.variable_reads++;
+		stats.variable_elements += extent[0] * extent[1];
+
+		double* window = &windows[(size_t) t * area];
+		long row, col;
+		for (row = r0; row <= r1; row++) {
+			for (col = c0; col <= c1; col++) {
+				window[(row - r + half) * size + (col - c + half)] = box[(row - r0) * extent[1] + (col - c0)];
+			}
+		}
+	}
+
+	if (DEBUG_WINDOW) printf("windows %s: %d x %d around %d targets, ok %d\n", table, size, size, located_count, ok);
+
+	free(box);
+	free(plan);
+	free(keys);
+	free(located);
+	free(group_dat);
+	free(name_dat);
+
+	H5Dclose(varid);
+	H5Gclose(grp_h5id);
+	H5Fclose(h5id);
+
+	return ok;
+}
+
+void print_window(FILE* fp, double* window, int size, window_variable* info, int summary) {
+
+	int i, area = size * size;
+
+	if (!summary) {
+		for (i = 0; i < area; i++) {
+			if (isnan(window[i])) {
+				fprintf(fp, " nan");
+			} else if (info->data_type == H5T_INTEGER) {
+				fprintf(fp, " %.0f", window[i]);
+			} else {
+				fprintf(fp, " %f", window[i]);
+			}
+		}
+		return;
+	}
+
+	int valid = 0;
+	double mean = 0, m2 = 0;
+	for (i = 0; i < area; i++) {
+		if (isnan(window[i]) || (info->has_fill && window[i] == info->fill)) continue;
+
+		valid++;
+		double delta = window[i] - mean;
+		mean += delta / valid;
+		m2 += delta * (window[i] - mean);
+	}
+
+	if (valid == 0) {
+		fprintf(fp, " 0 nan nan");
+	} else {
+		fprintf(fp, " %d %f %f", valid, mean, valid > 1 ? sqrt(m2 / (valid - 1)) : 0.);
+	}
+}